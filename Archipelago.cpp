@@ -0,0 +1,91 @@
+#include "Archipelago.hpp"
+#include "Random.hpp"
+
+#include <cassert>
+#include <cmath>
+
+void Island::advance( float elapsed, float step, float max_backlog )
+{
+	accumulator += elapsed;
+	if( accumulator > max_backlog )
+	{
+		float skipped = std::floor( accumulator / step ) * step;
+		grid.fast_forward( skipped );
+		accumulator -= skipped;
+		clock += skipped;
+	}
+	while( accumulator >= step )
+	{
+		grid.update( step );
+		accumulator -= step;
+		clock += step;
+	}
+}
+
+Island& Archipelago::add_island( int size_x, int size_y )
+{
+	uint32_t index = uint32_t( islands.size() );
+	islands.emplace_back( new Island() );
+	Island& island = *islands.back();
+	island.grid.resize( size_x, size_y );
+	island.grid.beacon_aura_radius = beacon_aura_radius;
+	// resize seeded the first island from the run seed already
+	if( index > 0 ) island.grid.seed_random( mix_seed( random_seed, island_stream_base + index ) );
+	for( int32_t x = 0; x < size_x; ++x )
+	{
+		for( int32_t y = 0; y < size_y; ++y )
+		{
+			island.grid.get_tile( x, y ).change_tile_type( empty_tile );
+		}
+	}
+	return island;
+}
+
+template< typename Fn >
+void Archipelago::run_islands( Fn const& fn )
+{
+	assert( visible >= 0 && visible < int( islands.size() ) );
+
+	// one job per island; their changes reach the observers only back here. The visible island's
+	// fine steps also spread its tiles over the workers, next to the other islands' jobs
+	Island const* shown = &get_visible();
+	for( auto& island : islands )
+	{
+		island->grid.hold_changes++;
+		island->grid.workers = island.get() == shown ? workers : nullptr;
+	}
+
+	// jobs are handed out in order: the visible island (the most steps) goes first
+	auto job = [&]( int job ){
+		int i = job == 0 ? visible : ( job <= visible ? job - 1 : job );
+		fn( *islands[i] );
+	};
+	int jobs = int( islands.size() );
+	if( workers ) workers->run( jobs, job );
+	else for( int j = 0; j < jobs; ++j ) job( j );
+
+	for( auto& island : islands )
+	{
+		if( --island->grid.hold_changes == 0 ) island->grid.flush_changes();
+	}
+}
+
+void Archipelago::show( int index )
+{
+	assert( index >= 0 && index < int( islands.size() ) );
+	visible = index;
+	get_visible().grid.workers = workers;
+}
+
+void Archipelago::update( float elapsed )
+{
+	run_islands( [this, elapsed]( Island& island ){ island.advance( elapsed, step, max_backlog ); } );
+}
+
+void Archipelago::fast_forward( float seconds )
+{
+	run_islands( [seconds]( Island& island ){
+		island.grid.fast_forward( seconds );
+		island.clock += seconds;
+	} );
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "TileGrid.hpp"
+#include "WorkerPool.hpp"
+
+#include <memory>
+#include <vector>
+
+/* One island of the world: a TileGrid with its own clock, stepped in fixed steps */
+struct Island
+{
+	TileGrid grid;
+	float clock = 0.0f; // seconds simulated so far
+	float accumulator = 0.0f; // time handed to update that isn't simulated yet
+
+	// simulate the steps that fit in the accumulated time; a backlog over max_backlog gets fast forwarded
+	void advance( float elapsed, float step, float max_backlog );
+};
+
+/* The islands of the world. Only one island is visible, but all of them take the same fixed steps, so an
+ * island comes out the same whichever one was shown meanwhile; the hidden ones just have no visuals to
+ * animate. Each island is one job on the workers, all of them running at once; the visible island
+ * also spreads its tiles over the workers (a nested WorkerPool::run), the others step serially inside.
+ * The change journals are held while the jobs run and flushed in island order afterwards, so the
+ * observers, which draw and play sounds, never run off the calling thread and the outcome doesn't depend
+ * on the thread count. */
+struct Archipelago
+{
+	std::vector< std::unique_ptr< Island > > islands;
+	int visible = 0;
+
+	// fixed step of every island's clock and the backlog that gets fast forwarded instead
+	float step = 1.0f / 60.0f;
+	float max_backlog = 1.0f;
+
+	// how far beacon flowers pass their aura on, given to every island (see TileGrid::beacon_aura_radius)
+	int beacon_aura_radius = 1;
+
+	// threads to spread islands and tiles on (serial if null)
+	WorkerPool* workers = nullptr;
+
+	// an island of empty tiles; island 0 draws tile randomness from the run seed, the others from streams of it
+	Island& add_island( int size_x, int size_y );
+	Island& get_visible() { return *islands[visible]; }
+	// make another island the visible one; it's as far along as the others already
+	void show( int index );
+
+	void update( float elapsed );
+	// TileGrid::fast_forward on every island
+	void fast_forward( float seconds );
+
+	// runs 'fn' on every island as jobs (see above)
+	template< typename Fn >
+	void run_islands( Fn const& fn );
+};
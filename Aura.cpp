@@ -1,183 +1,215 @@
 #include "Aura.hpp"
-#include "ColorTextureProgram.hpp"
+#include "AuraProgram.hpp"
+#include "Random.hpp"
 
 #include "gl_errors.hpp"
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
 
-static GLuint vbo = 0;
+AuraParticles aura_particles;
+
+// instances go into a ring buffer sized for every dot of the pool at once; when a frame doesn't fit in
+// what's left, the buffer gets orphaned and filling starts over at the front
+static GLuint ring_buffer = 0;
 static GLuint vao = 0;
-static GLuint white_tex = 0;
+static GLsizeiptr ring_offset = 0;
+static GLsizeiptr ring_size = 0;
+
+static GLsizeiptr pool_bytes() {
+	return GLsizeiptr(aura_particles.get_capacity()) * AuraParticles::MaxDotsPerEmitter * sizeof(DrawAura::Instance);
+}
 
 static Load< void > setup_gl(LoadTagDefault, [](){
 
 	glGenVertexArrays(1, &vao);
-	glGenBuffers(1, &vbo);
+	glGenBuffers(1, &ring_buffer);
 	glBindVertexArray(vao);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
-	glVertexAttribPointer(
-		color_texture_program->Position_vec4,
-		3, // size
-		GL_FLOAT, // type
-		GL_FALSE, // normalized
-		sizeof(Aura::Vertex), // stride size
-		(GLbyte*) 0 + offsetof(Aura::Vertex, position) // offset
-	);
-	glEnableVertexAttribArray(color_texture_program->Position_vec4);
-
-	glVertexAttribPointer(
-		color_texture_program->TexCoord_vec2, //attribute
-		2, //size
-		GL_FLOAT, //type
-		GL_FALSE, //normalized
-		sizeof(Aura::Vertex), // stride size
-		(GLbyte *) 0 + offsetof(Aura::Vertex, tex_coord) //offset
-	);
-	glEnableVertexAttribArray(color_texture_program->TexCoord_vec2);
-
-	glVertexAttribPointer(
-		color_texture_program->Color_vec4, //attribute
-		4, //size
-		GL_UNSIGNED_BYTE, //type
-		GL_TRUE, //normalized
-		sizeof(Aura::Vertex), //stride
-		(GLbyte *) 0 + offsetof(Aura::Vertex, color) //offset
-	);
-	glEnableVertexAttribArray(color_texture_program->Color_vec4);
+	glBindBuffer(GL_ARRAY_BUFFER, ring_buffer);
+	ring_size = pool_bytes();
+	glBufferData(GL_ARRAY_BUFFER, ring_size, nullptr, GL_STREAM_DRAW);
+
+	// pointers get set at each draw, to where that frame's instances start in the ring
+	glEnableVertexAttribArray(aura_program->CenterRadius_vec4);
+	glVertexAttribDivisor(aura_program->CenterRadius_vec4, 1);
+	glEnableVertexAttribArray(aura_program->Color_vec4);
+	glVertexAttribDivisor(aura_program->Color_vec4, 1);
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
-
-	//--- create 1x1 white texture
-	glGenTextures(1, &white_tex);
-	glBindTexture(GL_TEXTURE_2D, white_tex);
-
-	glm::uvec2 size = glm::uvec2(1,1);
-	std::vector<glm::u8vec4> data(size.x*size.y, glm::u8vec4(255,255,255,255));
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	
+	GL_ERRORS();
 });
 
-Aura::Aura(glm::vec3 _center, Type _type, int _max_strength) : type(_type), max_strength(_max_strength), center(_center) {
-	assert(_type != none);
-
-	dots = std::vector<Dot>();
-	for (int i=0; i<max_strength; i++) {
-		dots.emplace_back(_center, type);
+static glm::u8vec4 dot_color(AuraParticles::Type type) {
+	switch (type) {
+		case AuraParticles::fire: return glm::u8vec4(255, 42, 40, 255);
+		case AuraParticles::aqua: return glm::u8vec4(50, 135, 255, 255);
+		case AuraParticles::beacon: return glm::u8vec4(153, 89, 148, 255);
+		case AuraParticles::help: return glm::u8vec4(242, 236, 143, 255);
+		case AuraParticles::suck: return glm::u8vec4(94, 63, 138, 255);
+		default: assert(0 && "non-exhaustive match of aura type"); return glm::u8vec4(0);
 	}
-
 }
 
-inline float rand5() {
-	return float(rand() % 10000) / 10000.0f;
+AuraParticles::AuraParticles() {
+	grow(InitialEmitters);
 }
 
-Aura::Dot::Dot(glm::vec3 _center, Aura::Type type) : center(_center) {
-	timer = rand5() * 6.2832f;
-	dot_radius = rand5() * 0.03f + 0.015f;
-	float_height = (type==Aura::fire || type==Aura::aqua || type==Aura::beacon) ? rand5() * 0.6f + 0.2f : rand5() * 0.3f + 0.1f;
-	float_azimuth = rand5() * 2.0f * 3.1415926535f;
-	float_radius = (type==Aura::fire || type==Aura::aqua || type==Aura::beacon) ? rand5() * 0.4f + 0.1f : rand5() * 0.8f + 0.2f;
-	// float_speed_horizontal = glm::radians(rand5() * 30.0f + 45.0f);
-	float_speed_vertical = rand5() * 3.0f + 1.0f;
-	position = glm::vec3( cos(float_azimuth), sin(float_azimuth), float_height );
+void AuraParticles::grow(int capacity) {
+	int old_capacity = get_capacity();
+	assert(capacity > old_capacity);
+	emitters.resize(capacity);
+	// handed out from the front, after the ones that were free already
+	free_emitters.insert(free_emitters.begin(), capacity - old_capacity, 0);
+	for (int e = 0; e < capacity - old_capacity; ++e) {
+		free_emitters[e] = capacity - 1 - e;
+	}
+	size_t dots = size_t(capacity) * MaxDotsPerEmitter;
+	for (std::vector< float > *state : { &timer, &dot_radius, &float_height, &float_azimuth, &float_radius, &float_speed_vertical }) {
+		state->resize(dots, 0.0f);
+	}
+	position.resize(dots, glm::vec3(0.0f));
 }
 
-void Aura::Dot::update_position_jump(float elapsed) {
-	timer += elapsed;
-	position = center + float_radius * glm::vec3( 
-		cos(float_azimuth), sin(float_azimuth), 
-		float_height + 0.15f * sin(timer * float_speed_vertical) );
+inline float rand5() {
+	return aura_random.next_float();
 }
 
-void Aura::Dot::update_position_outward(float elapsed) {
-	timer += elapsed;
-	float_radius += elapsed * 0.15f;
-	if(float_radius > 1.0f) float_radius -= 0.8f;
-	position = center + float_radius * glm::vec3( 
-		cos(float_azimuth), sin(float_azimuth), 
-		float_height );
+int AuraParticles::add_emitter(glm::vec3 center, Type type, int max_strength) {
+	assert(type != none);
+	assert(max_strength >= 0 && max_strength <= MaxDotsPerEmitter);
+	if (free_emitters.empty()) {
+		std::cerr << "Aura pool ran out at " << get_capacity() << " emitters, growing it to " << 2 * get_capacity() << "." << std::endl;
+		grow(2 * get_capacity());
+	}
+	int e = free_emitters.back();
+	free_emitters.pop_back();
+
+	Emitter &emitter = emitters[e];
+	emitter.center = center;
+	emitter.type = type;
+	emitter.max_strength = max_strength;
+	emitter.strength = 0;
+
+	bool floats = (type == fire || type == aqua || type == beacon);
+	for (int i = e * MaxDotsPerEmitter; i < e * MaxDotsPerEmitter + max_strength; ++i) {
+		timer[i] = rand5() * 6.2832f;
+		dot_radius[i] = rand5() * 0.03f + 0.015f;
+		float_height[i] = floats ? rand5() * 0.6f + 0.2f : rand5() * 0.3f + 0.1f;
+		float_azimuth[i] = rand5() * 2.0f * 3.1415926535f;
+		float_radius[i] = floats ? rand5() * 0.4f + 0.1f : rand5() * 0.8f + 0.2f;
+		float_speed_vertical[i] = rand5() * 3.0f + 1.0f;
+		position[i] = center;
+	}
+	return e;
 }
 
-void Aura::Dot::update_position_inward(float elapsed) {
-	timer += elapsed;
-	float_radius -= elapsed * 0.15f;
-	if(float_radius < 0.2f) float_radius += 0.8f;
-	position = center + float_radius * glm::vec3( 
-		cos(float_azimuth), sin(float_azimuth), 
-		float_height + 0.15f * sin(timer * float_speed_vertical) );
+void AuraParticles::remove_emitter(int e) {
+	assert(e >= 0 && e < get_capacity() && emitters[e].type != none);
+	emitters[e] = Emitter();
+	free_emitters.push_back(e);
 }
 
-void Aura::update(int _strength, float elapsed, Scene::Transform* cam) {
-	strength = _strength;
-	assert(strength <= dots.size());
-
-	cam_transform = cam;
-
-	if( type == Aura::fire || type == Aura::aqua || type == Aura::beacon ) {
-		for(int i=0; i<strength; i++) {
-			dots[i].update_position_jump(elapsed);
+void AuraParticles::update_emitter(int e, int strength, float elapsed) {
+	Emitter &emitter = emitters[e];
+	assert(strength <= emitter.max_strength);
+	emitter.strength = strength;
+
+	int begin = e * MaxDotsPerEmitter;
+	int end = begin + strength;
+	glm::vec3 center = emitter.center;
+	if (emitter.type == fire || emitter.type == aqua || emitter.type == beacon) {
+		// jump in place
+		for (int i = begin; i < end; ++i) {
+			timer[i] += elapsed;
+			position[i] = center + float_radius[i] * glm::vec3(
+				std::cos(float_azimuth[i]), std::sin(float_azimuth[i]),
+				float_height[i] + 0.15f * std::sin(timer[i] * float_speed_vertical[i]) );
 		}
-	} else if( type == Aura::help ) {
-		for(int i=0; i<strength; i++) {
-			dots[i].update_position_outward(elapsed);
+	} else if (emitter.type == help) {
+		// drift outward; wraps around the same whether this runs every frame or once after a while off screen
+		for (int i = begin; i < end; ++i) {
+			timer[i] += elapsed;
+			float_radius[i] = 0.2f + std::fmod(float_radius[i] - 0.2f + elapsed * 0.15f, 0.8f);
+			position[i] = center + float_radius[i] * glm::vec3(
+				std::cos(float_azimuth[i]), std::sin(float_azimuth[i]),
+				float_height[i] );
 		}
-	} else if( type == Aura::suck ) {
-		for(int i=0; i<strength; i++) {
-			dots[i].update_position_inward(elapsed);
+	} else if (emitter.type == suck) {
+		// drift inward
+		for (int i = begin; i < end; ++i) {
+			timer[i] += elapsed;
+			float_radius[i] = 1.0f - std::fmod(1.0f - float_radius[i] + elapsed * 0.15f, 0.8f);
+			position[i] = center + float_radius[i] * glm::vec3(
+				std::cos(float_azimuth[i]), std::sin(float_azimuth[i]),
+				float_height[i] + 0.15f * std::sin(timer[i] * float_speed_vertical[i]) );
 		}
 	}
 }
 
-void Aura::draw(DrawAura &draw_aura) {
-
-	assert( cam_transform );
-	
-	for(int i=0; i<strength; i++) {
-		// turn it to face the camera
-		glm::vec3 c = dots[i].position; // center of dot
-		float r = dots[i].dot_radius;
-		glm::quat rotation = cam_transform->rotation;
-		Vertex tl = Vertex(r * (rotation * glm::vec3(-1, 1, 0)) + c, type);
-		Vertex tr = Vertex(r * (rotation * glm::vec3(1, 1, 0)) + c, type);
-		Vertex bl = Vertex(r * (rotation * glm::vec3(-1, -1, 0)) + c, type);
-		Vertex br = Vertex(r * (rotation * glm::vec3(1, -1, 0)) + c, type);
-		// make the square and append it to vbo
-		std::vector<Vertex> billboard_this = { tl, bl, br, tl, br, tr };	
-		draw_aura.vertices.insert(draw_aura.vertices.end(), billboard_this.begin(), billboard_this.end());
-	}
-
+static std::vector< DrawAura::Instance > &staging_instances() {
+	static std::vector< DrawAura::Instance > instances;
+	return instances;
 }
 
-DrawAura::~DrawAura() {
+DrawAura::DrawAura(glm::mat4 const &world_to_clip_, glm::quat const &camera_rotation_)
+	: world_to_clip(world_to_clip_), camera_rotation(camera_rotation_), instances(staging_instances()) {
+	instances.clear();
+}
 
-	// draw the dots w ColorTextureProgram
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Aura::Vertex), vertices.data(), GL_STREAM_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+void DrawAura::draw(int e) {
+	if (e < 0) return;
+	AuraParticles::Emitter const &emitter = aura_particles.emitters[e];
+	glm::u8vec4 color = dot_color(emitter.type);
+	int begin = e * AuraParticles::MaxDotsPerEmitter;
+	for (int i = begin; i < begin + emitter.strength; ++i) {
+		instances.push_back(Instance{ glm::vec4(aura_particles.position[i], aura_particles.dot_radius[i]), color });
+	}
+}
 
-	glUseProgram(color_texture_program->program);
-	glUniformMatrix4fv(
-			color_texture_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(world_to_clip));
+DrawAura::~DrawAura() {
+	if (instances.empty()) return;
+	GLsizeiptr bytes = GLsizeiptr(instances.size() * sizeof(Instance));
+
+	// append to the ring; the GPU may still read earlier parts, so those are left alone
+	glBindBuffer(GL_ARRAY_BUFFER, ring_buffer);
+	if (bytes > ring_size) {
+		// the pool grew since the ring was made, so the ring grows along
+		ring_size = std::max(bytes, pool_bytes());
+		glBufferData(GL_ARRAY_BUFFER, ring_size, nullptr, GL_STREAM_DRAW);
+		ring_offset = 0;
+	} else if (ring_offset + bytes > ring_size) {
+		glBufferData(GL_ARRAY_BUFFER, ring_size, nullptr, GL_STREAM_DRAW);
+		ring_offset = 0;
+	}
+	void *ring = glMapBufferRange(GL_ARRAY_BUFFER, ring_offset, bytes,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	std::memcpy(ring, instances.data(), bytes);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
 
 	glBindVertexArray(vao);
+	glVertexAttribPointer(aura_program->CenterRadius_vec4, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+		(GLbyte *)0 + ring_offset + offsetof(Instance, center_radius));
+	glVertexAttribPointer(aura_program->Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Instance),
+		(GLbyte *)0 + ring_offset + offsetof(Instance, color));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	ring_offset += bytes;
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, white_tex);
+	glUseProgram(aura_program->program);
+	glUniformMatrix4fv(aura_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(world_to_clip));
+	// dots face the camera
+	glm::vec3 right = camera_rotation * glm::vec3(1.0f, 0.0f, 0.0f);
+	glm::vec3 up = camera_rotation * glm::vec3(0.0f, 1.0f, 0.0f);
+	glUniform3fv(aura_program->CAMERA_RIGHT_vec3, 1, glm::value_ptr(right));
+	glUniform3fv(aura_program->CAMERA_UP_vec3, 1, glm::value_ptr(up));
 
-	glDrawArrays(GL_TRIANGLES, 0, GLsizei( vertices.size() ));
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, GLsizei(instances.size()));
 
-	glBindTexture(GL_TEXTURE_2D, 0);
 	glBindVertexArray(0);
 	glUseProgram(0);
 	GL_ERRORS();
-
 }
@@ -1,89 +1,63 @@
 #pragma once
 
-#include "Scene.hpp"
+#include "AuraKind.hpp"
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include <vector>
-#include <list>
-#include <iostream>
 
-// forward declaration
-struct DrawAura;
-
-// manages aura dots for a tile location (TODO: manage aura for all tiles? Or make it AuraType instead?)
-struct Aura { 
-
-	enum Type { fire, aqua, beacon, help, suck, none };
-
-	struct Dot {
-		Dot(glm::vec3 _center, Aura::Type type);
-		void update_position_jump(float elapsed);
-		void update_position_outward(float elapsed);
-		void update_position_inward(float elapsed);
-		// states
-		float timer;
-		glm::vec3 position = glm::vec3(0, 0, 1.2);
-		glm::vec3 center;
-		float float_radius, float_height, float_azimuth;
-		float float_speed_horizontal, float_speed_vertical;
-		float dot_radius = 0.2f;
+// the dots of every aura in one pool: each emitter (an aura on a tile) owns a fixed range of
+// dots, stored as structure-of-arrays so updating them is a few tight loops
+struct AuraParticles : AuraKind {
+	enum : int {
+		MaxDotsPerEmitter = 8, // emitter e owns dots [e * MaxDotsPerEmitter, e * MaxDotsPerEmitter + max_strength)
+		InitialEmitters = 1024, // the pool doubles whenever it runs out
 	};
 
-	struct Vertex {
-		Vertex(glm::vec3 _pos, Type type) : position(_pos) {
-			switch (type) {
-				case fire:
-					color = glm::u8vec4(255, 42, 40, 255);
-					break;
-				case aqua:
-					color = glm::u8vec4(50, 135, 255, 255);
-					break;
-				case beacon:
-					color = glm::u8vec4(153, 89, 148, 255);
-					break;
-				case help:
-					color = glm::u8vec4(242, 236, 143, 255);
-					break;
-				case suck:
-					color = glm::u8vec4(94, 63, 138, 255);
-					break;
-				default:
-					std::cout << "WARNING: non-exhaustive match of aura type??" << std::endl;
-					break;
-			}
-		}
-		glm::vec3 position;
-		glm::vec2 tex_coord = glm::vec2(0, 0);
-		glm::u8vec4 color;
+	AuraParticles();
+
+	// returns the emitter (>= 0), growing the pool if it's full
+	int add_emitter(glm::vec3 center, Type type, int max_strength = 5);
+	void remove_emitter(int emitter);
+	// animate the emitter's dots; only the first 'strength' of them show
+	void update_emitter(int emitter, int strength, float elapsed);
+	int get_max_strength(int emitter) const { return emitters[emitter].max_strength; }
+	int get_capacity() const { return int(emitters.size()); }
+	void grow(int capacity);
+
+	struct Emitter {
+		glm::vec3 center = glm::vec3(0.0f);
+		Type type = none; // none == free
+		int max_strength = 0; // num dots
+		int strength = 0;
 	};
-
-	Aura(glm::vec3 _center, Type _type, int _max_strength = 5);
-	void update(int _strength, float elapsed, Scene::Transform* cam);
-	void draw(DrawAura &draw_aura);
-	
-	// states
-	Type type;
-	int max_strength = 5; // num dots
-	int strength = 0;
-	glm::vec3 center;
-
-	// internals
-	std::vector<Dot> dots;
-	Scene::Transform* cam_transform = nullptr;
-	// std::vector<Vertex> dots_vbo;
-
-	// opengl-related stuff
-	GLuint vao, vbo, white_tex;
+	std::vector< Emitter > emitters;
+	std::vector< int > free_emitters;
+
+	// dot states
+	std::vector< float > timer;
+	std::vector< float > dot_radius;
+	std::vector< float > float_height, float_azimuth, float_radius;
+	std::vector< float > float_speed_vertical;
+	std::vector< glm::vec3 > position;
 };
 
+extern AuraParticles aura_particles;
+
+// collects the dots of the emitters to draw this frame, then draws them all at once
 struct DrawAura {
+	// what the GPU reads per dot; the vertex shader turns each into a camera-facing quad
+	struct Instance {
+		glm::vec4 center_radius;
+		glm::u8vec4 color;
+	};
 
-	DrawAura( glm::mat4 _world_to_clip ) : world_to_clip(_world_to_clip) {}
-	~DrawAura(); // actual drawing
+	DrawAura(glm::mat4 const &world_to_clip, glm::quat const &camera_rotation);
+	void draw(int emitter);
+	~DrawAura(); // one upload (into the ring buffer) and one draw call
 
 	// internals
-	std::vector<Aura::Vertex> vertices = {};
 	glm::mat4 world_to_clip;
-	// GLuint vao, vbo, white_tex;
-
+	glm::quat camera_rotation;
+	std::vector< Instance > &instances; // reused from frame to frame
 };
@@ -0,0 +1,7 @@
+#pragma once
+
+/* Kinds of aura a plant can give off. Shared by the tile simulation and the aura particles (Aura derives from this) */
+struct AuraKind
+{
+	enum Type { fire, aqua, beacon, help, suck, none };
+};
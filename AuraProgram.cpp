@@ -0,0 +1,51 @@
+#include "AuraProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+
+Load< AuraProgram > aura_program(LoadTagEarly);
+
+AuraProgram::AuraProgram() {
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"uniform vec3 CAMERA_RIGHT;\n"
+		"uniform vec3 CAMERA_UP;\n"
+		"in vec4 CenterRadius;\n"
+		"in vec4 Color;\n"
+		"out vec4 color;\n"
+		"const vec2 corners[6] = vec2[6](\n"
+		"	vec2(-1.0, 1.0), vec2(-1.0,-1.0), vec2( 1.0,-1.0),\n"
+		"	vec2(-1.0, 1.0), vec2( 1.0,-1.0), vec2( 1.0, 1.0)\n"
+		");\n"
+		"void main() {\n"
+		"	vec2 corner = corners[gl_VertexID];\n"
+		"	vec3 position = CenterRadius.xyz + CenterRadius.w * (corner.x * CAMERA_RIGHT + corner.y * CAMERA_UP);\n"
+		"	gl_Position = OBJECT_TO_CLIP * vec4(position, 1.0);\n"
+		"	color = Color;\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = color;\n"
+		"}\n"
+	);
+
+	//look up the locations of vertex attributes:
+	CenterRadius_vec4 = glGetAttribLocation(program, "CenterRadius");
+	Color_vec4 = glGetAttribLocation(program, "Color");
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+	CAMERA_RIGHT_vec3 = glGetUniformLocation(program, "CAMERA_RIGHT");
+	CAMERA_UP_vec3 = glGetUniformLocation(program, "CAMERA_UP");
+}
+
+AuraProgram::~AuraProgram() {
+	glDeleteProgram(program);
+	program = 0;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "GL.hpp"
+#include "Load.hpp"
+
+//Shader program that draws aura dots as camera-facing quads, one instance per dot (six vertices, no vertex buffer):
+struct AuraProgram {
+	AuraProgram();
+	~AuraProgram();
+
+	GLuint program = 0;
+	//Attribute (per-instance variable) locations:
+	GLuint CenterRadius_vec4 = -1U;
+	GLuint Color_vec4 = -1U;
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+	GLuint CAMERA_RIGHT_vec3 = -1U;
+	GLuint CAMERA_UP_vec3 = -1U;
+};
+
+extern Load< AuraProgram > aura_program;
@@ -0,0 +1,242 @@
+#include "AutoplayMode.hpp"
+
+//for the GL_ERRORS() macro:
+#include "gl_errors.hpp"
+
+//to mute the game:
+#include "Sound.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+AutoplayMode::Policy AutoplayMode::Policy::parse(std::string const &text) {
+	Policy policy;
+	std::istringstream str(text);
+	std::string entry;
+	while (std::getline(str, entry, ',')) {
+		if (entry.empty()) continue;
+		size_t eq = entry.find('=');
+		if (eq == std::string::npos) throw std::runtime_error("Autoplay policy entry '" + entry + "' isn't name=value.");
+		std::string name = entry.substr(0, eq);
+		float value = std::stof(entry.substr(eq + 1));
+		if (name == "plant") policy.plant = value;
+		else if (name == "water") policy.water = value;
+		else if (name == "fertilize") policy.fertilize = value;
+		else if (name == "dig") policy.dig = value;
+		else if (name == "harvest") policy.harvest = value;
+		else if (name == "orders") policy.orders = value;
+		else if (name == "rate") policy.rate = value;
+		else throw std::runtime_error("Unknown autoplay policy entry '" + name + "'.");
+	}
+	if (policy.rate <= 0.0f) throw std::runtime_error("Autoplay rate must be positive.");
+	return policy;
+}
+
+AutoplayMode::AutoplayMode(std::shared_ptr< PlantMode > const &game_, Policy const &policy_, uint32_t seed)
+	: game(game_), policy(policy_), random(mix_seed(seed, autoplay_stream)) {
+	assert(game);
+	Sound::set_volume(0.0f);
+	std::cout << "autoplay: plant " << policy.plant << ", water " << policy.water << ", fertilize " << policy.fertilize
+		<< ", dig " << policy.dig << ", harvest " << policy.harvest << ", orders " << policy.orders
+		<< ", " << policy.rate << " actions/s, seed " << seed << std::endl;
+}
+
+AutoplayMode::~AutoplayMode() {
+}
+
+bool AutoplayMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
+	if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_ESCAPE) {
+		log();
+		Mode::set_current(nullptr);
+		return true;
+	}
+	return false;
+}
+
+void AutoplayMode::update(float elapsed) {
+	//real time doesn't matter, run as many ticks as fit in the frame:
+	auto frame_start = std::chrono::high_resolution_clock::now();
+	do {
+		tick();
+	} while (std::chrono::duration< float >(std::chrono::high_resolution_clock::now() - frame_start).count() < frame_budget);
+}
+
+void AutoplayMode::draw(glm::uvec2 const &drawable_size) {
+	//rendering is off, just keep the window from showing garbage:
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	GL_ERRORS();
+}
+
+void AutoplayMode::tick() {
+	auto before = std::chrono::high_resolution_clock::now();
+
+	if (game->gameover) {
+		std::cout << "autoplay: game " << games << (game->state.outcome == GameState::won ? " won" : " lost")
+			<< " with main order " << game->state.current_main_order_idx << ", starting over" << std::endl;
+		game->reset_game();
+		++games;
+	}
+	//skip the title screen and never sit idle long enough for the inactivity reset:
+	game->paused = false;
+	game->title = false;
+	game->current_reset_time = game->inactivity_reset_time;
+
+	action_timer -= PlantMode::sim_step;
+	while (action_timer <= 0.0f) {
+		act();
+		action_timer += 1.0f / policy.rate;
+	}
+	game->update(PlantMode::sim_step);
+
+	double seconds = std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count();
+	uint32_t micros = uint32_t(seconds * 1e6);
+	uint32_t bucket = 0;
+	while (micros > 1 && bucket + 1 < tick_histogram.size()) {
+		micros >>= 1;
+		++bucket;
+	}
+	tick_histogram[bucket] += 1;
+	ticks += 1;
+	tick_seconds += seconds;
+	max_tick_seconds = std::max(max_tick_seconds, seconds);
+
+	log_timer += PlantMode::sim_step;
+	if (log_timer >= log_interval) {
+		log_timer -= log_interval;
+		minutes += 1;
+		log();
+	}
+}
+
+template< typename Want >
+GroundTile *AutoplayMode::pick_tile(Want const &want) {
+	//reservoir sampling over the tiles inside the grid:
+	GroundTile *picked = nullptr;
+	uint32_t seen = 0;
+	for (int32_t x = 0; x < game->grid->size_x; ++x) {
+		for (int32_t y = 0; y < game->grid->size_y; ++y) {
+			GroundTile &tile = game->grid->get_tile(x, y);
+			if (!want(tile)) continue;
+			seen += 1;
+			if (random.next_below(seen) == 0) picked = &tile;
+		}
+	}
+	return picked;
+}
+
+void AutoplayMode::act() {
+	float weights[6] = { policy.plant, policy.water, policy.fertilize, policy.dig, policy.harvest, policy.orders };
+	float total = 0.0f;
+	for (float w : weights) total += std::max(0.0f, w);
+	if (total <= 0.0f) return;
+	float pick = random.next_float() * total;
+	int action = 0;
+	while (action < 5 && pick >= std::max(0.0f, weights[action])) {
+		pick -= std::max(0.0f, weights[action]);
+		++action;
+	}
+
+	auto use_tool = [this](Tool tool, GroundTile *tile) {
+		if (!tile) return;
+		game->set_current_tool(tool);
+		game->use_tool(tile);
+		actions += 1;
+	};
+
+	if (action == 0) { //plant
+		std::vector< PlantType const * > with_seeds;
+		for (PlantType const *plant : game->state.unlocked_plants) {
+			if (game->state.get_seeds_num(plant) > 0) with_seeds.emplace_back(plant);
+		}
+		if (with_seeds.empty() && !game->state.unlocked_plants.empty()) {
+			PlantType const *plant = game->state.unlocked_plants[random.next_below(uint32_t(game->state.unlocked_plants.size()))];
+			if (game->buy_seed(plant)) with_seeds.emplace_back(plant);
+		}
+		if (with_seeds.empty()) return;
+		GroundTile *tile = pick_tile([](GroundTile &tile){ return tile.can_plant(); });
+		if (!tile) return;
+		game->selectedPlant = with_seeds[random.next_below(uint32_t(with_seeds.size()))];
+		use_tool(seed, tile);
+	} else if (action == 1) { //water
+		use_tool(watering_can, pick_tile([](GroundTile &tile){
+			return tile.plant_type && !tile.is_plant_dead() && tile.moisture() < 0.5f;
+		}));
+	} else if (action == 2) { //fertilize
+		if (game->state.num_coins < fertilization_cost) return;
+		use_tool(fertilizer, pick_tile([](GroundTile &tile){
+			return tile.plant_type && !tile.is_plant_dead() && tile.plant_health() < 0.5f;
+		}));
+	} else if (action == 3) { //dig
+		int coins = game->state.num_coins;
+		use_tool(shovel, pick_tile([coins](GroundTile &tile){
+			return tile.can_be_cleared() && tile.tile_type->get_clear_cost() <= coins;
+		}));
+	} else if (action == 4) { //harvest
+		use_tool(default_hand, pick_tile([](GroundTile &tile){
+			return tile.plant_type && (tile.is_tile_harvestable() || tile.is_plant_dead());
+		}));
+	} else { //orders
+		if (game->state.complete_order(GameState::main_order_slot)) {
+			actions += 1;
+			return;
+		}
+		if (game->state.complete_order(GameState::daily_order_slot)) {
+			actions += 1;
+			return;
+		}
+		//buy a seed for a requirement that isn't covered yet:
+		for (OrderType const *order : { game->state.current_main_order, game->state.current_daily_order }) {
+			if (!order) continue;
+			for (int id : order->get_required_ids()) {
+				PlantType const *plant = all_plants[id];
+				if (std::find(game->state.unlocked_plants.begin(), game->state.unlocked_plants.end(), plant) == game->state.unlocked_plants.end()) continue;
+				if (game->state.get_harvest_num(plant) + game->state.get_seeds_num(plant) >= order->get_required_plants()[id]) continue;
+				if (game->buy_seed(plant)) actions += 1;
+				return;
+			}
+		}
+	}
+}
+
+void AutoplayMode::log() {
+	uint32_t living = 0;
+	uint32_t dead = 0;
+	uint32_t fire_tiles = 0;
+	uint32_t aqua_tiles = 0;
+	uint32_t emitters = 0;
+	for (auto const &island : game->world.islands) {
+		TileGrid &grid = island->grid;
+		for (GroundTile &tile : grid.tiles) {
+			if (tile.plant_type) {
+				if (tile.is_plant_dead()) ++dead;
+				else ++living;
+			}
+			if (grid.fire_aura_effect[tile.index] > 0.0f) ++fire_tiles;
+			if (grid.aqua_aura_effect[tile.index] > 0.0f) ++aqua_tiles;
+			//(the emitter arrays only hold values during a step, so count the plants that give off an aura)
+			if (tile.plant_type && !tile.is_plant_dead() && tile.plant_type->get_aura_type() != AuraKind::none) ++emitters;
+		}
+	}
+
+	std::cout << "autoplay minute " << minutes << ": " << ticks << " ticks";
+	if (ticks) {
+		std::cout << ", mean " << (tick_seconds * 1e3 / ticks) << " ms, max " << (max_tick_seconds * 1e3) << " ms";
+	}
+	std::cout << ", " << actions << " actions\n  tick us:";
+	for (uint32_t b = 0; b < tick_histogram.size(); ++b) {
+		if (tick_histogram[b]) std::cout << " [" << (b ? (1u << b) : 0u) << "," << (2u << b) << "):" << tick_histogram[b];
+	}
+	std::cout << "\n  plants: " << living << " living, " << dead << " dead"
+		<< "; auras: " << fire_tiles << " fire tiles, " << aqua_tiles << " aqua tiles, " << emitters << " emitters"
+		<< "; $" << game->state.num_coins << ", main order " << game->state.current_main_order_idx << ", game " << games << std::endl;
+
+	tick_histogram.fill(0);
+	ticks = 0;
+	tick_seconds = 0.0;
+	max_tick_seconds = 0.0;
+	actions = 0;
+}
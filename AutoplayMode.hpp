@@ -0,0 +1,73 @@
+#pragma once
+
+/*
+ * AutoplayMode plays a PlantMode by itself, for soak testing the game logic.
+ * Each action it picks a tool with a weighted random policy, finds a tile that tool does something to
+ * and goes through the same calls as the mouse (PlantMode::use_tool, buy_seed, GameState::complete_order).
+ * The game is stepped as fast as it will go with nothing drawn, and every simulated minute
+ * a histogram of tick times, the living plants and the aura counts are logged.
+ *
+ * Started with: ./demo --autoplay [policy]
+ *  where policy is a comma separated list of weights over the defaults, e.g. plant=4,water=2,orders=0,rate=8
+ */
+
+#include "PlantMode.hpp"
+#include "Random.hpp"
+
+#include <array>
+#include <memory>
+#include <string>
+
+struct AutoplayMode : Mode {
+	struct Policy {
+		// relative weights of the actions:
+		float plant = 4.0f; //seed an empty tile (buying seeds when out)
+		float water = 2.0f; //water a dry plant
+		float fertilize = 1.0f; //fertilize a hurt plant
+		float dig = 1.0f; //clear a tile
+		float harvest = 4.0f; //harvest a grown plant or remove a dead one
+		float orders = 2.0f; //complete satisfied orders, otherwise buy seeds the orders need
+		float rate = 4.0f; //actions per simulated second
+
+		//parses "name=value,..." on top of the defaults (throws on unknown names):
+		static Policy parse(std::string const &text);
+	};
+
+	AutoplayMode(std::shared_ptr< PlantMode > const &game, Policy const &policy, uint32_t seed);
+	virtual ~AutoplayMode();
+
+	//functions called by main loop:
+	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
+	virtual void update(float elapsed) override;
+	virtual void draw(glm::uvec2 const &drawable_size) override;
+
+	std::shared_ptr< PlantMode > game;
+	Policy policy;
+	RandomStream random;
+
+	//ticks run back to back until this much real time went by, then the frame ends so events get handled:
+	const float frame_budget = 0.05f;
+	//simulated seconds between log lines:
+	const float log_interval = 60.0f;
+
+	//one fixed step of the game (PlantMode::sim_step), with the actions due before it:
+	void tick();
+	void act();
+	//uniform pick among the tiles 'want' is true for (nullptr if none):
+	template< typename Want >
+	GroundTile *pick_tile(Want const &want);
+	void log();
+
+	float action_timer = 0.0f;
+	float log_timer = 0.0f;
+	uint32_t minutes = 0;
+	uint32_t games = 1;
+
+	//tick times since the last log, bucket b counts ticks in [2^b, 2^(b+1)) microseconds (bucket 0 from 0):
+	std::array< uint32_t, 20 > tick_histogram = {};
+	uint32_t ticks = 0;
+	double tick_seconds = 0.0;
+	double max_tick_seconds = 0.0;
+	//tool uses, purchases and completed orders since the last log:
+	uint32_t actions = 0;
+};
@@ -20,6 +20,8 @@ Load< Scene > spheres_scene_forward(LoadTagLate, []() -> Scene const * {
 		Mesh const &mesh = spheres_meshes->lookup(mesh_name);
 
 		scene.drawables.emplace_back(transform);
+		scene.drawables.back().bounds_min = mesh.min;
+		scene.drawables.back().bounds_max = mesh.max;
 		Scene::Drawable::Pipeline &pipeline = scene.drawables.back().pipeline;
 		pipeline = basic_material_forward_program_pipeline;
 		pipeline.vao = spheres_for_basic_material_forward;
@@ -29,7 +31,7 @@ Load< Scene > spheres_scene_forward(LoadTagLate, []() -> Scene const * {
 
 		float roughness = 1.0f;
 		if (transform->name.substr(0, 9) == "Icosphere") {
-			roughness = (transform->position.y + 10.0f) / 18.0f;
+			roughness = (transform->get_position().y + 10.0f) / 18.0f;
 		}
 		pipeline.set_uniforms = [roughness](){
 			glUniform1f(basic_material_forward_program->ROUGHNESS_float, roughness);
@@ -48,12 +50,13 @@ DemoLightingForwardMode::~DemoLightingForwardMode() {
 void DemoLightingForwardMode::draw(glm::uvec2 const &drawable_size) {
 	//--- use camera structure to set up scene camera ---
 
-	scene_camera->transform->rotation =
+	scene_camera->transform->set_rotation(
 		glm::angleAxis(camera.azimuth, glm::vec3(0.0f, 0.0f, 1.0f))
 		* glm::angleAxis(0.5f * 3.1415926f + -camera.elevation, glm::vec3(1.0f, 0.0f, 0.0f))
-	;
-	scene_camera->transform->position = camera.target + camera.radius * (scene_camera->transform->rotation * glm::vec3(0.0f, 0.0f, 1.0f));
-	scene_camera->transform->scale = glm::vec3(1.0f);
+	);
+	scene_camera->transform->set_position(camera.target + camera.radius * (scene_camera->transform->get_rotation() * glm::vec3(0.0f, 0.0f, 1.0f)));
+	scene_camera->transform->set_scale(glm::vec3(1.0f));
+	camera_scene.update_transforms(); //(read below, before any draw does it)
 	scene_camera->aspect = float(drawable_size.x) / float(drawable_size.y);
 
 
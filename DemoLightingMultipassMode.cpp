@@ -22,6 +22,8 @@ Load< Scene > spheres_scene_multipass(LoadTagLate, []() -> Scene const * {
 		Mesh const &mesh = spheres_meshes->lookup(mesh_name);
 
 		scene.drawables.emplace_back(transform);
+		scene.drawables.back().bounds_min = mesh.min;
+		scene.drawables.back().bounds_max = mesh.max;
 		Scene::Drawable::Pipeline &pipeline = scene.drawables.back().pipeline;
 		pipeline = basic_material_program_pipeline;
 		pipeline.vao = spheres_for_basic_material;
@@ -31,7 +33,7 @@ Load< Scene > spheres_scene_multipass(LoadTagLate, []() -> Scene const * {
 
 		float roughness = 1.0f;
 		if (transform->name.substr(0, 9) == "Icosphere") {
-			roughness = (transform->position.y + 10.0f) / 18.0f;
+			roughness = (transform->get_position().y + 10.0f) / 18.0f;
 		}
 		pipeline.set_uniforms = [roughness](){
 			glUniform1f(basic_material_program->ROUGHNESS_float, roughness);
@@ -83,7 +85,7 @@ bool DemoLightingMultipassMode::handle_event(SDL_Event const &evt, glm::uvec2 co
 			if (SDL_GetModState() & KMOD_SHIFT) {
 				//shift: pan
 
-				glm::mat3 frame = glm::mat3_cast(scene_camera->transform->rotation);
+				glm::mat3 frame = glm::mat3_cast(scene_camera->transform->get_rotation());
 				camera.target -= frame[0] * (delta.x * camera.radius) + frame[1] * (delta.y * camera.radius);
 			} else {
 				//no shift: tumble
@@ -118,12 +120,13 @@ bool DemoLightingMultipassMode::handle_event(SDL_Event const &evt, glm::uvec2 co
 void DemoLightingMultipassMode::draw(glm::uvec2 const &drawable_size) {
 	//--- use camera structure to set up scene camera ---
 
-	scene_camera->transform->rotation =
+	scene_camera->transform->set_rotation(
 		glm::angleAxis(camera.azimuth, glm::vec3(0.0f, 0.0f, 1.0f))
 		* glm::angleAxis(0.5f * 3.1415926f + -camera.elevation, glm::vec3(1.0f, 0.0f, 0.0f))
-	;
-	scene_camera->transform->position = camera.target + camera.radius * (scene_camera->transform->rotation * glm::vec3(0.0f, 0.0f, 1.0f));
-	scene_camera->transform->scale = glm::vec3(1.0f);
+	);
+	scene_camera->transform->set_position(camera.target + camera.radius * (scene_camera->transform->get_rotation() * glm::vec3(0.0f, 0.0f, 1.0f)));
+	scene_camera->transform->set_scale(glm::vec3(1.0f));
+	camera_scene.update_transforms(); //(read below, before any draw does it)
 	scene_camera->aspect = float(drawable_size.x) / float(drawable_size.y);
 
 
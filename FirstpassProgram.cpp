@@ -72,3 +72,38 @@ FirstpassProgram::~FirstpassProgram() {
 	program = 0;
 }
 
+
+Load< FirstpassInstancedProgram > firstpass_instanced_program(LoadTagEarly);
+
+FirstpassInstancedProgram::FirstpassInstancedProgram() {
+	std::ifstream vertex_fs(data_path("firstpass_instanced.vert"));
+	std::string vert_content(
+		(std::istreambuf_iterator<char>(vertex_fs)), std::istreambuf_iterator<char>() );
+
+	//shades exactly like the non-instanced program:
+	std::ifstream fragment_fs(data_path("firstpass.frag"));
+	std::string frag_content(
+		(std::istreambuf_iterator<char>(fragment_fs)), std::istreambuf_iterator<char>() );
+
+	program = gl_compile_program(
+		//vertex shader:
+		vert_content,
+		//fragment shader:
+		frag_content
+	);
+
+	//look up the locations of vertex attributes:
+	Position_vec4 = glGetAttribLocation(program, "Position");
+	Normal_vec3 = glGetAttribLocation(program, "Normal");
+	Color_vec4 = glGetAttribLocation(program, "Color");
+	TexCoord_vec2 = glGetAttribLocation(program, "TexCoord");
+
+	//look up the locations of uniforms:
+	WORLD_TO_CLIP_mat4 = glGetUniformLocation(program, "WORLD_TO_CLIP");
+	WORLD_TO_LIGHT_mat4x3 = glGetUniformLocation(program, "WORLD_TO_LIGHT");
+}
+
+FirstpassInstancedProgram::~FirstpassInstancedProgram() {
+	glDeleteProgram(program);
+	program = 0;
+}
@@ -30,3 +30,24 @@ extern Load< FirstpassProgram > firstpass_program;
 //For convenient scene-graph setup, copy this object:
 // NOTE: by default, has texture bound to 1-pixel white texture -- so it's okay to use with vertex-color-only meshes.
 extern Scene::Drawable::Pipeline firstpass_program_pipeline;
+
+//The same shading for Scene's instanced drawing, with object transform and PROPERTIES per instance:
+struct FirstpassInstancedProgram {
+	FirstpassInstancedProgram();
+	~FirstpassInstancedProgram();
+
+	GLuint program = 0;
+
+	//Attribute (per-vertex variable) locations:
+	GLuint Position_vec4 = -1U;
+	GLuint Normal_vec3 = -1U;
+	GLuint Color_vec4 = -1U;
+	GLuint TexCoord_vec2 = -1U;
+	//(per-instance attributes are bound by name; see Scene::get_instance_attribs)
+
+	//Uniform (per-invocation variable) locations:
+	GLuint WORLD_TO_CLIP_mat4 = -1U;
+	GLuint WORLD_TO_LIGHT_mat4x3 = -1U;
+};
+
+extern Load< FirstpassInstancedProgram > firstpass_instanced_program;
@@ -0,0 +1,176 @@
+#include "GameState.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+void GameState::reset()
+{
+	outcome = playing;
+	num_coins = starting_coins;
+	if( observer ) observer->on_coins_changed();
+	for( PlantType const* plant : all_plants )
+	{
+		lock_plant( plant );
+		change_seeds_num( plant, -get_seeds_num( plant ) );
+		change_harvest_num( plant, -get_harvest_num( plant ) );
+	}
+	unlock_plant( test_plant );
+	change_seeds_num( test_plant, starting_seeds );
+	set_main_order( 0 );
+	set_daily_order( 0 );
+}
+
+void GameState::change_seeds_num( PlantType const* plant, int change )
+{
+	assert( plant );
+	seeds[plant->get_id()] += change;
+	order_tracker.change_seeds_num( plant, change );
+	if( observer ) observer->on_seeds_changed( plant );
+}
+
+void GameState::change_harvest_num( PlantType const* plant, int change )
+{
+	assert( plant );
+	harvests[plant->get_id()] += change;
+	order_tracker.change_harvest_num( plant, change );
+	if( observer ) observer->on_harvests_changed( plant );
+}
+
+bool GameState::is_unlocked( PlantType const* plant ) const
+{
+	return std::find( unlocked_plants.begin(), unlocked_plants.end(), plant ) != unlocked_plants.end();
+}
+
+void GameState::unlock_plant( PlantType const* plant )
+{
+	if( is_unlocked( plant ) ) return;
+	unlocked_plants.emplace_back( plant );
+	if( observer ) observer->on_plant_unlocked( plant );
+}
+
+void GameState::lock_plant( PlantType const* plant )
+{
+	auto it = std::find( unlocked_plants.begin(), unlocked_plants.end(), plant );
+	if( it == unlocked_plants.end() ) return;
+	unlocked_plants.erase( it );
+	if( observer ) observer->on_plant_unlocked( plant );
+}
+
+void GameState::set_main_order( int index )
+{
+	current_main_order_idx = index;
+	current_main_order = main_orders[index];
+	order_tracker.set_order( main_order_slot, current_main_order );
+	if( observer ) observer->on_order_changed( main_order_slot );
+}
+
+void GameState::set_daily_order( int index )
+{
+	current_daily_order_idx = index;
+	// the tracker still looks at the old order while switching, so a generated one only goes after that
+	std::unique_ptr< OrderType const > old_order = std::move( generated_daily_order );
+	if( daily_random || size_t( index ) >= daily_orders.size() )
+	{
+		generated_daily_order.reset( generate_random_daily_order( daily_random ? *daily_random : order_random ) );
+		current_daily_order = generated_daily_order.get();
+	}
+	else
+	{
+		current_daily_order = daily_orders[index];
+	}
+	order_tracker.set_order( daily_order_slot, current_daily_order );
+	if( observer ) observer->on_order_changed( daily_order_slot );
+}
+
+void GameState::change_num_coins( int change )
+{
+	num_coins += change;
+	if( observer ) observer->on_coins_changed();
+	if( current_main_order && current_daily_order && get_debt() > num_coins ) finish( lost );
+}
+
+int GameState::get_debt() const
+{
+	// the tracker keeps what's left to buy for each order up to date
+	int debt = order_tracker.get_missing_cost( main_order_slot );
+	if( order_tracker.get_missing_cost( daily_order_slot ) <= num_coins )
+	{
+		debt -= current_daily_order->get_bonus_cash();
+	}
+	return debt;
+}
+
+void GameState::finish( Outcome outcome_in )
+{
+	if( outcome != playing ) return;
+	outcome = outcome_in;
+	if( observer ) observer->on_game_over();
+}
+
+bool GameState::buy_seed( PlantType const* plant )
+{
+	if( num_coins < plant->get_cost() ) return false;
+	change_num_coins( -plant->get_cost() );
+	change_seeds_num( plant, 1 );
+	return true;
+}
+
+bool GameState::complete_order( int slot )
+{
+	OrderType const* order = order_tracker.get_order( slot );
+	if( !order || !order_tracker.is_satisfied( slot ) ) return false;
+	if( observer ) observer->on_order_completed( slot );
+	PerPlant< int > const& require_plants = order->get_required_plants();
+	for( int id : order->get_required_ids() )
+	{
+		change_harvest_num( all_plants[id], -require_plants[id] );
+	}
+
+	if( slot == main_order_slot )
+	{
+		if( order->get_bonus_plant() ) unlock_plant( order->get_bonus_plant() );
+		change_num_coins( order->get_bonus_cash() );
+		if( current_main_order_idx + 1 >= int( main_orders.size() ) ) finish( won );
+		else set_main_order( current_main_order_idx + 1 );
+	}
+	else
+	{
+		change_num_coins( order->get_bonus_cash() );
+		set_daily_order( current_daily_order_idx + 1 >= int( daily_orders.size() ) ? 0 : current_daily_order_idx + 1 );
+	}
+	return true;
+}
+
+bool GameState::plant_seed( GroundTile& tile, PlantType const* plant )
+{
+	if( get_seeds_num( plant ) <= 0 || !tile.try_add_plant( plant ) ) return false;
+	change_seeds_num( plant, -1 );
+	return true;
+}
+
+bool GameState::remove_plant( GroundTile& tile )
+{
+	PlantType const* plant = tile.plant_type;
+	if( !plant ) return false;
+	bool harvest = tile.is_tile_harvestable();
+	if( !tile.try_remove_plant() || !harvest ) return false;
+	change_harvest_num( plant, 1 );
+	return true;
+}
+
+bool GameState::clear_tile( GroundTile& tile )
+{
+	if( !tile.can_be_cleared() ) return false;
+	int cost = tile.tile_type->get_clear_cost();
+	if( cost > num_coins || !tile.try_clear_tile() ) return false;
+	change_num_coins( -cost );
+	return true;
+}
+
+bool GameState::fertilize_tile( GroundTile& tile )
+{
+	if( fertilization_cost > num_coins || !tile.plant_type || tile.is_plant_dead() || tile.plant_health() >= 1.0f ) return false;
+	change_num_coins( -fertilization_cost );
+	tile.fertilization() = fertilization_duration;
+	return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Order.hpp"
+#include "Random.hpp"
+#include "TileGrid.hpp"
+
+#include <memory>
+#include <vector>
+
+/* Gets told about changes to a GameState, once each change is done */
+struct GameObserver
+{
+	virtual ~GameObserver() { }
+	virtual void on_coins_changed() { }
+	virtual void on_seeds_changed( PlantType const* plant ) { }
+	virtual void on_harvests_changed( PlantType const* plant ) { }
+	// unlocked or locked again (see GameState::is_unlocked)
+	virtual void on_plant_unlocked( PlantType const* plant ) { }
+	// another order in the slot
+	virtual void on_order_changed( int slot ) { }
+	// called before the order's reward and the next order come in
+	virtual void on_order_completed( int slot ) { }
+	// the game got won or lost (see GameState::outcome)
+	virtual void on_game_over() { }
+};
+
+/* The rules of a game apart from the tiles: coins, seeds and harvests, the unlocked plants and the
+ * main and daily orders, with what the player does to them. Nothing in here draws or plays sounds,
+ * so PlantMode and batchsim play by the same rules; PlantMode shows the changes as a GameObserver */
+struct GameState
+{
+	static constexpr int main_order_slot = 0;
+	static constexpr int daily_order_slot = 1;
+	static constexpr int starting_coins = 30;
+	static constexpr int starting_seeds = 5; // of test_plant, the only plant unlocked at the start
+
+	enum Outcome { playing, won, lost };
+	Outcome outcome = playing;
+
+	int num_coins = starting_coins;
+	std::vector< PlantType const* > unlocked_plants;
+
+	int current_main_order_idx = 0;
+	OrderType const* current_main_order = nullptr;
+	int current_daily_order_idx = 0;
+	OrderType const* current_daily_order = nullptr;
+	// remaining counts of the orders, by slot (track the grids the plants grow on with it)
+	OrderTracker order_tracker;
+	// daily orders get generated from this stream if set, and past the end of daily_orders from order_random
+	RandomStream* daily_random = nullptr;
+
+	GameObserver* observer = nullptr;
+
+	// starting coins and seeds, nothing harvested, only test_plant unlocked and the first orders
+	void reset();
+
+	int get_seeds_num( PlantType const* plant ) const { return plant ? seeds[plant->get_id()] : 0; }
+	void change_seeds_num( PlantType const* plant, int change );
+	int get_harvest_num( PlantType const* plant ) const { return plant ? harvests[plant->get_id()] : 0; }
+	void change_harvest_num( PlantType const* plant, int change );
+
+	bool is_unlocked( PlantType const* plant ) const;
+	void unlock_plant( PlantType const* plant );
+	void lock_plant( PlantType const* plant );
+
+	void set_main_order( int index );
+	void set_daily_order( int index );
+
+	// a game that can't pay for its orders anymore is lost
+	void change_num_coins( int change );
+	// coins still needed for the orders: the main order's missing plants, less the daily order's
+	// reward if its missing plants are affordable
+	int get_debt() const;
+
+	// What the player does, false if there aren't enough coins, seeds or plants for it
+	bool buy_seed( PlantType const* plant );
+	// hand over the order's plants for its reward, and move on to the next order
+	bool complete_order( int slot );
+	bool plant_seed( GroundTile& tile, PlantType const* plant );
+	// takes the plant off the tile, true if it was harvestable and went into the harvests
+	bool remove_plant( GroundTile& tile );
+	bool clear_tile( GroundTile& tile );
+	bool fertilize_tile( GroundTile& tile );
+
+private:
+	PerPlant< int > seeds = {};
+	PerPlant< int > harvests = {};
+	std::unique_ptr< OrderType const > generated_daily_order;
+
+	void finish( Outcome outcome_in );
+};
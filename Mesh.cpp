@@ -1,5 +1,6 @@
 #include "Mesh.hpp"
 #include "read_write_chunk.hpp"
+#include "Scene.hpp"
 
 #include <glm/glm.hpp>
 
@@ -122,3 +123,14 @@ GLuint MeshBuffer::make_vao_for_program(GLuint program) const {
 
 	return ::make_vao_for_program(attribs, program);
 }
+
+GLuint MeshBuffer::make_instanced_vao_for_program(GLuint program) const {
+	std::map< std::string, Attrib const * > attribs = Scene::get_instance_attribs();
+
+	attribs["Position"] = &Position;
+	attribs["Normal"] = &Normal;
+	attribs["Color"] = &Color;
+	attribs["TexCoord"] = &TexCoord;
+
+	return ::make_vao_for_program(attribs, program);
+}
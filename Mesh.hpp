@@ -44,6 +44,8 @@ struct MeshBuffer {
 	//build a vertex array object that links this vbo to attributes to a program:
 	// note: will throw if program defines attributes not contained in this buffer
 	GLuint make_vao_for_program(GLuint program) const;
+	//...same, plus the per-instance attributes of Scene's instanced drawing:
+	GLuint make_instanced_vao_for_program(GLuint program) const;
 
 	//This is the OpenGL vertex buffer object containing the mesh data:
 	GLuint buffer = 0;
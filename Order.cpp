@@ -1,25 +1,15 @@
 #define _CRT_SECURE_NO_WARNINGS
 
 #include "Load.hpp"
-// #include "Mesh.hpp"
-// #include "Scene.hpp"
-#include "gl_errors.hpp"
 #include "data_path.hpp"
-#include "Sprite.hpp"
-#include "DrawSprites.hpp"
 #include "Order.hpp"
+#include "Random.hpp"
 #include <cstddef>
 #include <algorithm>
 #include <iostream>
-#include "PlantMode.hpp"
 
-#include <glm/gtc/type_ptr.hpp>
-#include <glm/gtc/matrix_transform.hpp>
 #include <fstream>
 #include <sstream>
-#include <map>
-#include <random>
-#include <unordered_map>
 
 std::vector< OrderType const* > main_orders;
 std::vector< OrderType const* > daily_orders;
@@ -35,6 +25,10 @@ PlantType const* get_plant_type_by_name(std::string plant_type_name){
 		return cactus_plant;
 	}else if(plant_type_name=="fireflower_plant"){
 		return fireflower_plant;
+	}else if(plant_type_name=="waterflower_plant"){
+		return waterflower_plant;
+	}else if(plant_type_name=="beaconflower_plant"){
+		return beaconflower_plant;
 	}else if(plant_type_name=="corpseeater_plant"){
 		return corpseeater_plant;
 	}
@@ -53,15 +47,15 @@ PlantType const* get_plant_type_by_name(std::string plant_type_name){
 }
 
 // Randomly generate daily order with combination of different required plants
-OrderType const* generate_random_daily_order(){
-	std::map< PlantType const*, int > rand_require_plants;
-	int rand_required_plants_type_num = rand()%3+1;
+OrderType const* generate_random_daily_order(RandomStream& order_random){
+	PerPlant< int > rand_require_plants = {};
+	int rand_required_plants_type_num = order_random.next_below(3)+1;
 	int rand_bonus_energy = 0;
 	for(int i=0;i<rand_required_plants_type_num;i++){
-		int rand_required_num = rand()%5+1;
-		rand_bonus_energy += rand()%125 + 55;
-		int rand_plant_type = rand()%all_plants.size();
-		rand_require_plants.insert(std::pair<PlantType const*, int>(all_plants[rand_plant_type],rand_required_num));
+		int rand_required_num = order_random.next_below(5)+1;
+		rand_bonus_energy += order_random.next_below(125) + 55;
+		int rand_plant_type = order_random.next_below(uint32_t(all_plants.size()));
+		if(rand_require_plants[rand_plant_type] == 0) rand_require_plants[rand_plant_type] = rand_required_num;
 	}
 	OrderType const* tmp_daily_order = new OrderType("random order", "Someone ordered these..",rand_require_plants, rand_bonus_energy,nullptr);
 	return tmp_daily_order;
@@ -73,7 +67,7 @@ Load< void > daily_order_load_from_file(LoadTagLate, []() {
 	std::string line;
 	std::string tmp_title;
 	std::string tmp_description;
-	std::map< PlantType const*, int > tmp_require_plants;
+	PerPlant< int > tmp_require_plants = {};
 	int tmp_bonus_energy=0;
 	
 	int new_order_count = 0;
@@ -103,7 +97,9 @@ Load< void > daily_order_load_from_file(LoadTagLate, []() {
 			int pos = (int)line.find(" ");
 			std::string tmp_name = line.substr(0,pos);
 			int plant_num = std::stoi(line.substr(pos+1));
-			tmp_require_plants.insert( std::pair<PlantType const*, int>(get_plant_type_by_name(tmp_name), plant_num));
+			PlantType const* tmp_plant = get_plant_type_by_name(tmp_name);
+			assert(tmp_plant);
+			if(tmp_require_plants[tmp_plant->get_id()] == 0) tmp_require_plants[tmp_plant->get_id()] = plant_num;
 			// std::cout <<tmp_name<< " " << plant_num<< std::endl;
 			new_order_count += 1;
 		}else if(new_order_count == num_of_plants_type+4){
@@ -126,7 +122,7 @@ Load< void > daily_order_load_from_file(LoadTagLate, []() {
 				new_order_count =0;
 				new_order_count = 0;
 	 			num_of_plants_type = 0;
-				tmp_require_plants.erase(tmp_require_plants.begin(),tmp_require_plants.end());
+				tmp_require_plants.fill(0);
 			}
 		}
 		
@@ -140,10 +136,6 @@ Load< void > daily_order_load_from_file(LoadTagLate, []() {
 	// validity check
 	for (auto order : daily_orders) {
 		assert(order);
-		auto reqs = order->get_required_plants();
-		for (auto req : reqs) {
-			assert(req.first);
-		}
 	}
 
 	std::cout << "----all daily orders loaded." << std::endl;
@@ -155,7 +147,7 @@ Load< void > main_order_load_from_file(LoadTagLate, []() {
 	std::string line;
 	std::string tmp_title;
 	std::string tmp_description;
-	std::map< PlantType const*, int > tmp_require_plants;
+	PerPlant< int > tmp_require_plants = {};
 	int tmp_bonus_energy=0;
 	
 	int new_order_count = 0;
@@ -185,7 +177,9 @@ Load< void > main_order_load_from_file(LoadTagLate, []() {
 			int pos = (int)line.find(" ");
 			std::string tmp_name = line.substr(0,pos);
 			int plant_num = std::stoi(line.substr(pos+1));
-			tmp_require_plants.insert( std::pair<PlantType const*, int>(get_plant_type_by_name(tmp_name), plant_num));
+			PlantType const* tmp_plant = get_plant_type_by_name(tmp_name);
+			assert(tmp_plant);
+			if(tmp_require_plants[tmp_plant->get_id()] == 0) tmp_require_plants[tmp_plant->get_id()] = plant_num;
 			// std::cout <<tmp_name<< " " << plant_num<< std::endl;
 			new_order_count += 1;
 		}else if(new_order_count == num_of_plants_type+4){
@@ -208,7 +202,7 @@ Load< void > main_order_load_from_file(LoadTagLate, []() {
 				new_order_count =0;
 				new_order_count = 0;
 	 			num_of_plants_type = 0;
-				tmp_require_plants.erase(tmp_require_plants.begin(),tmp_require_plants.end());
+				tmp_require_plants.fill(0);
 			}
 		}
 		
@@ -216,11 +210,109 @@ Load< void > main_order_load_from_file(LoadTagLate, []() {
 	// validity check
 	for (auto order : main_orders) {
 		assert(order);
-		auto reqs = order->get_required_plants();
-		for (auto req : reqs) {
-			assert(req.first);
-		}
 	}
 	std::cout << "----all main orders loaded." << std::endl;
 });
 
+
+void OrderTracker::track( TileGrid& grid_in )
+{
+	grid_in.observers.push_back( this );
+	grids.emplace_back();
+	grids.back().grid = &grid_in;
+	recount_grid( grids.back() );
+}
+
+void OrderTracker::set_order( int slot, OrderType const* order )
+{
+	assert( slot >= 0 && slot < max_slots );
+	if( slot >= int( slots.size() ) ) slots.resize( slot + 1 );
+	uint64_t bit = uint64_t( 1 ) << slot;
+	Slot& s = slots[slot];
+	if( s.order )
+	{
+		for( int id : s.order->get_required_ids() ) slots_requiring[id] &= ~bit;
+	}
+	s = Slot();
+	s.order = order;
+	satisfied &= ~bit;
+	if( !order ) return;
+
+	PerPlant< int > const& required = order->get_required_plants();
+	for( int id : order->get_required_ids() )
+	{
+		slots_requiring[id] |= bit;
+		s.unharvested[id] = required[id] - harvests[id];
+		s.unowned[id] = required[id] - owned[id];
+		if( s.unharvested[id] > 0 ) ++s.unmet;
+		if( s.unowned[id] > 0 ) s.missing_cost += all_plants[id]->get_cost() * s.unowned[id];
+	}
+	if( s.unmet == 0 ) satisfied |= bit;
+}
+
+void OrderTracker::change_harvest_num( PlantType const* plant, int change )
+{
+	assert( plant );
+	change_owned( plant->get_id(), change, change );
+}
+
+void OrderTracker::change_seeds_num( PlantType const* plant, int change )
+{
+	assert( plant );
+	change_owned( plant->get_id(), 0, change );
+}
+
+void OrderTracker::change_owned( int id, int harvest_change, int owned_change )
+{
+	harvests[id] += harvest_change;
+	owned[id] += owned_change;
+
+	int cost = all_plants[id]->get_cost();
+	uint64_t mask = slots_requiring[id];
+	for( int slot = 0; slot < max_slots && ( mask >> slot ); ++slot )
+	{
+		uint64_t bit = uint64_t( 1 ) << slot;
+		if( !( mask & bit ) ) continue;
+		Slot& s = slots[slot];
+
+		bool was_unmet = s.unharvested[id] > 0;
+		s.unharvested[id] -= harvest_change;
+		s.unmet += int( s.unharvested[id] > 0 ) - int( was_unmet );
+
+		s.missing_cost -= cost * std::max( 0, s.unowned[id] );
+		s.unowned[id] -= owned_change;
+		s.missing_cost += cost * std::max( 0, s.unowned[id] );
+
+		if( s.unmet == 0 ) satisfied |= bit;
+		else satisfied &= ~bit;
+	}
+}
+
+void OrderTracker::recount_tile( GroundTile& tile )
+{
+	// a handful of islands at most, a scan beats a map
+	auto tracked = std::find_if( grids.begin(), grids.end(), [&tile]( TrackedGrid const& t ){ return t.grid == tile.grid; } );
+	if( tracked == grids.end() ) return;
+	// the grid was resized since the last count
+	if( tracked->living_plant.size() != tracked->grid->tiles.size() )
+	{
+		recount_grid( *tracked );
+		return;
+	}
+	int8_t id = tile.plant_type && !tile.is_plant_dead() ? int8_t( tile.plant_type->get_id() ) : -1;
+	int8_t& counted = tracked->living_plant[tile.index];
+	if( id == counted ) return;
+	if( counted >= 0 ) change_owned( counted, 0, -1 );
+	counted = id;
+	if( id >= 0 ) change_owned( id, 0, 1 );
+}
+
+void OrderTracker::recount_grid( TrackedGrid& tracked )
+{
+	for( int8_t id : tracked.living_plant )
+	{
+		if( id >= 0 ) change_owned( id, 0, -1 );
+	}
+	tracked.living_plant.assign( tracked.grid->tiles.size(), -1 );
+	for( GroundTile& tile : tracked.grid->tiles ) recount_tile( tile );
+}
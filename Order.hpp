@@ -1,6 +1,8 @@
 #pragma once
-#include "Plant.hpp"
+#include "TileGrid.hpp"
+#include <algorithm>
 #include <list>
+#include <map>
 
 struct Inventory;
 
@@ -9,18 +11,25 @@ struct OrderType
 {
 	OrderType(std::string title_in = "Default Order Title",
 			std::string description_in = "Default Order Description",
-			const std::map<PlantType const*, int> require_plants_in = {},
+			PerPlant< int > const& require_plants_in = {},
 			int bonus_cash_in = 100,
 			PlantType const* bonus_plant_in = test_plant):
 		title(title_in),
 		description(description_in),
 		require_plants(require_plants_in),
 		bonus_cash(bonus_cash_in),
-		bonus_plant(bonus_plant_in){};
+		bonus_plant(bonus_plant_in){
+		for (int id = 0; id < plant_type_count; id++) {
+			if (require_plants[id] > 0) required_ids.push_back(id);
+		}
+	};
 
 	std::string get_title() const { return title; };
 	std::string get_description() const { return description; };
-	std::map<PlantType const*, int> get_required_plants() const {return require_plants;};
+	// how many of each plant type the order needs (0 for the ones it doesn't)
+	PerPlant< int > const& get_required_plants() const {return require_plants;};
+	// ids of the plants with a nonzero count above, ascending
+	std::vector< int > const& get_required_ids() const {return required_ids;};
 	int get_bonus_cash() const { return bonus_cash; };
 	PlantType const* get_bonus_plant() const {return bonus_plant;};
 
@@ -32,7 +41,8 @@ struct OrderType
 private:
 	std::string title = "Default Order Title";
 	std::string description = "Default Order Description";
-	std::map<PlantType const*, int> require_plants = {};
+	PerPlant< int > require_plants = {};
+	std::vector< int > required_ids;
 	int bonus_cash = 100;
 	PlantType const* bonus_plant = test_plant;
 	glm::u8vec4 text_col = glm::u8vec4(92, 76, 53, 255);
@@ -40,4 +50,63 @@ private:
 
 extern std::vector< OrderType const* > main_orders;
 extern std::vector< OrderType const* > daily_orders;
-extern OrderType const* generate_random_daily_order();
+// a new OrderType every call, from the order_random stream unless given another one
+extern OrderType const* generate_random_daily_order(RandomStream& random = order_random);
+// plant type by its name in the order files ("test_plant", ...), nullptr if unknown
+extern PlantType const* get_plant_type_by_name(std::string plant_type_name);
+
+/* Keeps what the shown orders still need up to date as the inventory and the tiles change.
+ * Every order sits in a slot, which is its bit in the satisfied mask. Each plant id knows the
+ * slots that require it, so a change only touches those, and checking an order is a bit test. */
+struct OrderTracker : public TileObserver
+{
+	static constexpr int max_slots = 64;
+
+	// count the living plants on this grid too from now on
+	void track( TileGrid& grid );
+	// put an order in a slot (nullptr empties it)
+	void set_order( int slot, OrderType const* order );
+	OrderType const* get_order( int slot ) const { return slot < int( slots.size() ) ? slots[slot].order : nullptr; }
+
+	// inventory deltas (Inventory forwards these)
+	void change_harvest_num( PlantType const* plant, int change );
+	void change_seeds_num( PlantType const* plant, int change );
+
+	// the harvests cover every plant the order requires
+	bool is_satisfied( int slot ) const { return ( satisfied >> slot ) & 1; }
+	uint64_t get_satisfied() const { return satisfied; }
+	// coins still needed to buy the required plants that aren't harvested, seeds or living on a tile
+	int get_missing_cost( int slot ) const { return slots[slot].missing_cost; }
+	// how many of a plant the above is paying for
+	int get_missing_num( int slot, PlantType const* plant ) const { return std::max( 0, slots[slot].unowned[plant->get_id()] ); }
+
+	virtual void on_plant_changed( GroundTile& tile ) override { recount_tile( tile ); }
+	virtual void on_plant_died( GroundTile& tile ) override { recount_tile( tile ); }
+	virtual void on_teleport( GroundTile& from, GroundTile& to ) override { recount_tile( from ); recount_tile( to ); }
+
+private:
+	struct Slot
+	{
+		OrderType const* order = nullptr;
+		PerPlant< int > unharvested = {}; // required minus harvested
+		PerPlant< int > unowned = {}; // required minus harvested, seeds and living plants
+		int unmet = 0; // plant ids with unharvested > 0
+		int missing_cost = 0;
+	};
+	std::vector< Slot > slots;
+	PerPlant< uint64_t > slots_requiring = {};
+	uint64_t satisfied = 0;
+
+	PerPlant< int > harvests = {};
+	PerPlant< int > owned = {}; // harvests, seeds and living plants
+	struct TrackedGrid
+	{
+		TileGrid* grid = nullptr;
+		std::vector< int8_t > living_plant; // per tile, id of the living plant counted for it or -1
+	};
+	std::vector< TrackedGrid > grids;
+
+	void change_owned( int id, int harvest_change, int owned_change );
+	void recount_tile( GroundTile& tile );
+	void recount_grid( TrackedGrid& tracked );
+};
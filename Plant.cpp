@@ -7,32 +7,18 @@
 #include "Scene.hpp"
 #include "gl_errors.hpp"
 #include "data_path.hpp"
+#include <cmath>
 #include <cstddef>
 #include <algorithm>
 #include <iostream>
+#include <unordered_map>
+#include <unordered_set>
 #include "Sound.hpp"
 
-float plant_time = 0;
 const MeshBuffer* plant_mesh_buffer;
 glm::vec2 plant_grid_tile_size = glm::vec2( 1.0f, 1.0f );
-PlantType const* test_plant = nullptr;
-PlantType const* friend_plant = nullptr;
-PlantType const* vampire_plant = nullptr;
-PlantType const* cactus_plant = nullptr;
-PlantType const* fireflower_plant = nullptr;
-PlantType const* waterflower_plant = nullptr;
-PlantType const* beaconflower_plant = nullptr;
-PlantType const* corpseeater_plant = nullptr;
-PlantType const* spreader_source_plant = nullptr;
-PlantType const* spreader_child_plant = nullptr;
-PlantType const* teleporter_plant = nullptr;
-GroundTileType const* sea_tile = nullptr;
-std::vector< PlantType const* > all_plants;
-GroundTileType const* ground_tile = nullptr;
-GroundTileType const* dirt_tile = nullptr;
-GroundTileType const* grass_short_tile = nullptr;
-GroundTileType const* grass_tall_tile = nullptr;
-GroundTileType const* empty_tile = nullptr;
+PerPlant< PlantLook > plant_looks;
+std::unordered_map< GroundTileType const*, Mesh const* > tile_meshes;
 
 // ground tiles
 Mesh const* sea_mesh = nullptr;
@@ -147,11 +133,14 @@ Load< MeshBuffer > plant_meshes( LoadTagDefault, [](){
 	grass_tall_tile_mesh = &ret->lookup( "tallgrass" );
 	empty_tile_mesh = new Mesh();
 
-	ground_tile = new GroundTileType( true, ground_tile_mesh, -1 );
-	dirt_tile = new GroundTileType( false, dirt_tile_mesh, 40 );
-	grass_short_tile = new GroundTileType( false, grass_short_tile_mesh, 50 );
-	grass_tall_tile = new GroundTileType( false, grass_tall_tile_mesh, 60 );
-	empty_tile = new GroundTileType( false, empty_tile_mesh, -1 );
+	// the rules for tiles and plants come from the simulation, this only attaches meshes and sprites
+	create_plant_types();
+
+	tile_meshes[ground_tile] = ground_tile_mesh;
+	tile_meshes[dirt_tile] = dirt_tile_mesh;
+	tile_meshes[grass_short_tile] = grass_short_tile_mesh;
+	tile_meshes[grass_tall_tile] = grass_tall_tile_mesh;
+	tile_meshes[empty_tile] = empty_tile_mesh;
 
 	// PLANT MESHES -------------------------------------------------
 	dead_plant_mesh = &ret->lookup( "deadplant" );
@@ -186,51 +175,21 @@ Load< MeshBuffer > plant_meshes( LoadTagDefault, [](){
 	teleporter_2_mesh = &ret->lookup( "teleporter2" );
 	teleporter_3_mesh = &ret->lookup( "teleporter3" );
 
-	test_plant = new PlantType( { test_plant_1_mesh, test_plant_2_mesh }, fern_seed_sprite, fern_harvest_sprite, 
-								  Aura::none, 5, 0, 20.0f, "Familiar Fern", 
-								"Cheap plant. Grows anywhere." );
-	friend_plant = new PlantType( { friend_plant_1_mesh, friend_plant_2_mesh, friend_plant_3_mesh }, friend_plant_seed_sprite, friend_plant_harvest_sprite, 
-								  Aura::help, 10, 0, 30.0f, "Companion Carrot", 
-								  "Speeds up growth of adjacent plants. Needs 2 neighbors to grow." );
-	vampire_plant = new PlantType( { vampire_plant_1_mesh, vampire_plant_2_mesh, vampire_plant_3_mesh },vampire_plant_seed_sprite, vampire_plant_harvest_sprite, 
-								   Aura::suck, 20, 0, 50.0f, "Sap Sucker", 
-								   "Grows by stealing life from adjacent plants. 3 plants sustain it." );
-	cactus_plant = new PlantType( { cactus_1_mesh, cactus_2_mesh, cactus_3_mesh }, cactus_seed_sprite, cactus_harvest_sprite, 
-								  Aura::none, 10, 0, 60.0f, "Crisp Cactus", 
-								  "Grows only in fire aura from fire flowers." );
-	fireflower_plant = new PlantType( { fireflower_1_mesh, fireflower_2_mesh, fireflower_3_mesh }, fireflower_seed_sprite, fireflower_harvest_sprite, 
-									  Aura::fire, 5, 0, 20.0f, "Fire Flower", 
-									  "Gives off fire aura." );
-	waterflower_plant = new PlantType( { waterflower_1_mesh, waterflower_2_mesh, waterflower_3_mesh }, waterflower_seed_sprite, waterflower_harvest_sprite, 
-									  Aura::aqua, 5, 0, 20.0f, "Sieve Flower", 
-									  "Gives off aqua aura." );
-	beaconflower_plant = new PlantType( { beaconflower_1_mesh, beaconflower_2_mesh, beaconflower_3_mesh }, beaconflower_seed_sprite, beaconflower_harvest_sprite, 
-									  Aura::beacon, 20, 0, 40.0f, "Beacon Flower", 
-									  "Gives off whatever aura it is planted in." );								  
-	corpseeater_plant = new PlantType( { corpseeater_1_mesh, corpseeater_2_mesh, corpseeater_3_mesh }, corpseeater_seed_sprite, corpseeater_harvest_sprite, 
-									   Aura::none, 5, 0, 40.0f, "Detritus Dahlia", 
-									   "Feeds off an adjacent dead plant." );
-	spreader_source_plant = new PlantType( { spreader_source_1_mesh, spreader_source_2_mesh }, spreader_seed_sprite, spreader_source_harvest_sprite,
-										   Aura::none, 5, 0, 10.0f, "Spreading Sage", 
-										   "Once fully grown tries to spread all over the farm." );
-	spreader_child_plant = new PlantType( { spreader_child_1_mesh, spreader_child_2_mesh }, spreader_seed_sprite, spreader_child_harvest_sprite, 
-										  Aura::none, 5, 0, 5.0f, "Spreading Sage Child", 
-										  "Offshoot of the Spreading Sage" );
-	teleporter_plant = new PlantType( { teleporter_1_mesh, teleporter_2_mesh, teleporter_3_mesh }, teleporter_seed_sprite, teleporter_harvest_sprite, 
-									  Aura::none, 5, 0, 40.0f, "Teleporting Twinleaf", 
-									  "Teleports around the field while growing." );
-
-	all_plants.push_back(test_plant);
-	all_plants.push_back(friend_plant);
-	all_plants.push_back(vampire_plant);
-	all_plants.push_back(cactus_plant);
-	all_plants.push_back(fireflower_plant);
-	all_plants.push_back(waterflower_plant);
-	all_plants.push_back(beaconflower_plant);
-	all_plants.push_back(corpseeater_plant);
-	all_plants.push_back(spreader_source_plant);
-	all_plants.push_back( spreader_child_plant );
-	all_plants.push_back(teleporter_plant);
+	plant_looks[test_plant->get_id()] = PlantLook{ { test_plant_1_mesh, test_plant_2_mesh }, fern_seed_sprite, fern_harvest_sprite };
+	plant_looks[friend_plant->get_id()] = PlantLook{ { friend_plant_1_mesh, friend_plant_2_mesh, friend_plant_3_mesh }, friend_plant_seed_sprite, friend_plant_harvest_sprite };
+	plant_looks[vampire_plant->get_id()] = PlantLook{ { vampire_plant_1_mesh, vampire_plant_2_mesh, vampire_plant_3_mesh }, vampire_plant_seed_sprite, vampire_plant_harvest_sprite };
+	plant_looks[cactus_plant->get_id()] = PlantLook{ { cactus_1_mesh, cactus_2_mesh, cactus_3_mesh }, cactus_seed_sprite, cactus_harvest_sprite };
+	plant_looks[fireflower_plant->get_id()] = PlantLook{ { fireflower_1_mesh, fireflower_2_mesh, fireflower_3_mesh }, fireflower_seed_sprite, fireflower_harvest_sprite };
+	plant_looks[waterflower_plant->get_id()] = PlantLook{ { waterflower_1_mesh, waterflower_2_mesh, waterflower_3_mesh }, waterflower_seed_sprite, waterflower_harvest_sprite };
+	plant_looks[beaconflower_plant->get_id()] = PlantLook{ { beaconflower_1_mesh, beaconflower_2_mesh, beaconflower_3_mesh }, beaconflower_seed_sprite, beaconflower_harvest_sprite };
+	plant_looks[corpseeater_plant->get_id()] = PlantLook{ { corpseeater_1_mesh, corpseeater_2_mesh, corpseeater_3_mesh }, corpseeater_seed_sprite, corpseeater_harvest_sprite };
+	plant_looks[spreader_source_plant->get_id()] = PlantLook{ { spreader_source_1_mesh, spreader_source_2_mesh }, spreader_seed_sprite, spreader_source_harvest_sprite };
+	plant_looks[spreader_child_plant->get_id()] = PlantLook{ { spreader_child_1_mesh, spreader_child_2_mesh }, spreader_seed_sprite, spreader_child_harvest_sprite };
+	plant_looks[teleporter_plant->get_id()] = PlantLook{ { teleporter_1_mesh, teleporter_2_mesh, teleporter_3_mesh }, teleporter_seed_sprite, teleporter_harvest_sprite };
+	for( PlantType const* plant : all_plants )
+	{
+		assert( int( plant_looks[plant->get_id()].meshes.size() ) == plant->get_stage_count() );
+	}
 	
 	plant_mesh_buffer = ret;
 
@@ -241,6 +200,10 @@ Load< GLuint > plant_meshes_for_firstpass_program( LoadTagDefault, [](){
 	return new GLuint( plant_meshes->make_vao_for_program( firstpass_program->program ) );
 } );
 
+Load< GLuint > plant_meshes_for_firstpass_instanced_program( LoadTagDefault, [](){
+	return new GLuint( plant_meshes->make_instanced_vao_for_program( firstpass_instanced_program->program ) );
+} );
+
 Load< Sound::Sample > plant_death_sound( LoadTagDefault, []() -> Sound::Sample const* {
 	return new Sound::Sample( data_path( "PlantDeath.wav" ) );
 										 } );
@@ -253,21 +216,61 @@ Load< GLuint > plant_meshes_for_water_program( LoadTagDefault, [](){
 	return new GLuint( plant_meshes->make_vao_for_program( water_program->program ) );
 } );
 
-TileGrid setup_grid_for_scene( Scene& scene, int plant_grid_x, int plant_grid_y )
+PlantLook const& get_plant_look( PlantType const* plant )
 {
+	assert( plant );
+	return plant_looks[plant->get_id()];
+}
+
+Mesh const* get_tile_mesh( GroundTileType const* tile_type )
+{
+	auto it = tile_meshes.find( tile_type );
+	assert( it != tile_meshes.end() );
+	return it->second;
+}
 
-	TileGrid grid;
-	// Make the tile grid
+TileGridView::~TileGridView()
+{
+	for( size_t i = 0; i < tiles.size(); ++i )
 	{
-		grid.tiles = new GroundTile * [plant_grid_x];
-		for( int32_t x = 0; x < plant_grid_x; ++x )
+		remove_all_auras( int( i ) );
+	}
+	if( grid )
+	{
+		grid->observers.erase( std::remove( grid->observers.begin(), grid->observers.end(), this ), grid->observers.end() );
+	}
+}
+
+void TileGridView::clear( Scene& scene )
+{
+	std::unordered_set< void const* > owned;
+	for( size_t i = 0; i < tiles.size(); ++i )
+	{
+		remove_all_auras( int( i ) );
+		for( Scene::Drawable* drawable : { tiles[i].tile_drawable, tiles[i].plant_drawable } )
 		{
-			grid.tiles[x] = new GroundTile[plant_grid_y];
+			if( !drawable ) continue;
+			owned.insert( drawable );
+			owned.insert( drawable->transform );
 		}
 	}
+	scene.drawables.remove_if( [&owned]( Scene::Drawable const& d ){ return owned.count( &d ); } );
+	scene.transforms.remove_if( [&owned]( Scene::Transform const& t ){ return owned.count( &t ); } );
+	tiles.clear();
+	if( grid )
+	{
+		grid->observers.erase( std::remove( grid->observers.begin(), grid->observers.end(), this ), grid->observers.end() );
+		grid = nullptr;
+	}
+}
 
-	grid.size_x = plant_grid_x;
-	grid.size_y = plant_grid_y;
+void TileGridView::setup( TileGrid& grid_in, Scene& scene )
+{
+	grid = &grid_in;
+	grid->observers.push_back( this );
+	tiles.assign( grid->tiles.size(), TileVisuals() );
+	int plant_grid_x = grid->size_x;
+	int plant_grid_y = grid->size_y;
 
 	//Populate the tile grid (default is sea)
 	{
@@ -276,11 +279,11 @@ TileGrid setup_grid_for_scene( Scene& scene, int plant_grid_x, int plant_grid_y
 		default_info.vao = *plant_meshes_for_firstpass_program;
 		default_info.start = 0;
 		default_info.count = 0;
-		// set default uniforms
-		GLint PROPERTIES_vec3_loc = firstpass_program->PROPERTIES_vec3;
-		default_info.set_uniforms = [PROPERTIES_vec3_loc](){
-			glUniform3f(PROPERTIES_vec3_loc, 1.0f, 0.0f, 0.0f);
-		};
+		// tiles and plants sharing a mesh are drawn in one go, with health and moisture per instance
+		default_info.instanced.program = firstpass_instanced_program->program;
+		default_info.instanced.vao = *plant_meshes_for_firstpass_instanced_program;
+		default_info.instanced.WORLD_TO_CLIP_mat4 = firstpass_instanced_program->WORLD_TO_CLIP_mat4;
+		default_info.instanced.WORLD_TO_LIGHT_mat4x3 = firstpass_instanced_program->WORLD_TO_LIGHT_mat4x3;
 
 		glm::vec3 tile_center_pos = glm::vec3( ( (float)plant_grid_x - 1 ) * plant_grid_tile_size.x / 2.0f, ( (float)plant_grid_y - 1 ) * plant_grid_tile_size.y / 2.0f, 0.0f );
 
@@ -288,601 +291,227 @@ TileGrid setup_grid_for_scene( Scene& scene, int plant_grid_x, int plant_grid_y
 		{
 			for( int32_t y = 0; y < plant_grid_y; ++y )
 			{
-				// Set coordinates
-				grid.tiles[x][y].grid_x = x;
-				grid.tiles[x][y].grid_y = y;
+				GroundTile& grid_tile = grid->get_tile( x, y );
+				TileVisuals& visuals = tiles[grid_tile.index];
 
 				// Set up tile drawable and initial pipline for each tile
 				scene.transforms.emplace_back();
 				Scene::Transform* tile_transform = &scene.transforms.back();
-				tile_transform->position = glm::vec3( plant_grid_tile_size.x * x, plant_grid_tile_size.y * y, 0.0f ) - tile_center_pos;
-				grid.tiles[x][y].plant_position = tile_transform->position;
+				tile_transform->set_position( glm::vec3( plant_grid_tile_size.x * x, plant_grid_tile_size.y * y, 0.0f ) - tile_center_pos );
+				visuals.plant_position = tile_transform->get_position();
 				scene.drawables.emplace_back( tile_transform );
 				Scene::Drawable* tile = &scene.drawables.back();
 				tile->pipeline = default_info;
-				grid.tiles[x][y].tile_drawable = tile;
+				visuals.tile_drawable = tile;
 
 				// Set up plant drawable and initial pipline for each plant (empty)
 				scene.transforms.emplace_back();
 				Scene::Transform* plant_transform = &scene.transforms.back();
-				plant_transform->position = glm::vec3( plant_grid_tile_size.x * x, plant_grid_tile_size.y * y, 0.0f ) - tile_center_pos;
+				plant_transform->set_position( glm::vec3( plant_grid_tile_size.x * x, plant_grid_tile_size.y * y, 0.0f ) - tile_center_pos );
 				scene.drawables.emplace_back( plant_transform );
 				Scene::Drawable* plant = &scene.drawables.back();
 				plant->pipeline = default_info;
-				grid.tiles[x][y].plant_drawable = plant;
-
-				// Set default type for the tile
-				grid.tiles[x][y].change_tile_type( empty_tile );
+				visuals.plant_drawable = plant;
 
+				// catch up with the tile's current state
+				if( grid_tile.tile_type ) on_tile_type_changed( grid_tile );
+				on_plant_changed( grid_tile );
+				on_aura_changed( grid_tile );
 			}
 		}
 	}
-
-	return grid;
 }
 
-void GroundTile::change_tile_type( const GroundTileType* tile_type_in )
+void TileGridView::update( float elapsed, float alpha, glm::mat4 const& world_to_clip )
 {
-	if( tile_type_in )
+	time += elapsed;
+	// sleeping tiles have nothing to animate
+	for( int index : grid->active_tiles )
 	{
-		tile_type = tile_type_in;
-		moisture = 1.0f;
-		tile_drawable->pipeline.start = tile_type->get_mesh()->start;
-		tile_drawable->pipeline.count = tile_type->get_mesh()->count;
-		
-		GLint PROPERTIES_vec3_loc = firstpass_program->PROPERTIES_vec3;
-		if( tile_type->get_can_plant() ) {
-			tile_drawable->pipeline.set_uniforms = [this, PROPERTIES_vec3_loc](){
-				glUniform3f(PROPERTIES_vec3_loc, 1.0f, moisture, 0.0f);
-			};
-		} else {
-			tile_drawable->pipeline.set_uniforms = [PROPERTIES_vec3_loc](){
-				glUniform3f(PROPERTIES_vec3_loc, 1.0f, 0.0f, 0.0f);
-			};
-		}
-	}
-	else
-	{
-		printf( "ERROR Passed in null tile type! \n" );
-	}
-}
-
-void GroundTile::update( float elapsed, Scene::Transform* camera_transform, const TileGrid& grid )
-{
-	shake = glm::mix( shake, 0.0f, 0.05f );
-
-	// update plant state
-	if( plant_type )
-	{
-		float grow_power = elapsed * std::sqrtf(plant_health);
-
-		if( !is_plant_dead() )
+		GroundTile& tile = grid->tiles[index];
+		TileVisuals& visuals = tiles[index];
+		// read by the instanced draw, which has no other way to the tile
+		update_properties( tile );
+		glm::vec4 clip = world_to_clip * glm::vec4( visuals.plant_position, 1.0f );
+		float edge = clip.w * view_margin;
+		visuals.in_view = clip.w > 0.0f && std::abs( clip.x ) <= edge && std::abs( clip.y ) <= edge;
+		if( !visuals.in_view )
 		{
-			// PLANT BEHAVIORS -----------------------------------------------------------------------------------
-			if( plant_type == test_plant )
-			{
-				current_grow_time += grow_power + elapsed * std::sqrtf(moisture);
-			}
-			else if( plant_type == friend_plant )
-			{
-				int neighbor = 0;
-				for( int x = -1; x <= 1; x += 2 )
-				{
-					if( grid_x + x >= 0 && grid_x + x < grid.size_x )
-					{
-						GroundTile& tile = grid.tiles[grid_x + x][grid_y];
-						const PlantType* plant = tile.plant_type;
-						if( plant && !tile.is_plant_dead() )
-						{
-							neighbor++;
-							//Boost the neighbor
-							tile.current_grow_time += elapsed * 0.4f;
-						}
-					}
-				}
-				for( int y = -1; y <= 1; y += 2 )
-				{
-					if( grid_y + y >= 0 && grid_y + y < grid.size_y )
-					{
-						GroundTile& tile = grid.tiles[grid_x][grid_y + y];
-						const PlantType* plant = tile.plant_type;
-						if( plant && !tile.is_plant_dead() )
-						{
-							neighbor++;
-							//Boost the neighbor
-							tile.current_grow_time += elapsed * 0.4f;
-						}
-					}
-				}
-
-				if( neighbor >= 2 )
-				{
-					current_grow_time += grow_power + elapsed * std::sqrtf(moisture);
-				}
-				else
-				{
-					change_health(- elapsed * ( plant_health_restore_rate + 0.1f ));
-				}
-			}
-			else if( plant_type == vampire_plant )
-			{
-				std::vector<GroundTile*> victims;
-
-				for( int i = 0; i < 4; ++i )
-				{
-					int x = i < 2 ? 2 * i - 1 : 0;
-					int y = i < 2 ? 0 : 2 * ( i - 2 ) - 1;
-					if( grid_x + x >= 0 && grid_x + x < grid.size_x && grid_y + y >= 0 && grid_y + y < grid.size_y )
-					{
-						GroundTile& tile = grid.tiles[grid_x + x][grid_y + y];
-						const PlantType* plant = tile.plant_type;
-						if( plant && !tile.is_plant_dead() )
-						{
-							victims.push_back( &tile );
-						}
-					}
-				}
-
-				if( victims.size() > 0 )
-				{
-					victims[rand() % victims.size()]->change_health (- elapsed * ( 2*plant_health_restore_rate + 0.2f ));
-					current_grow_time += grow_power + elapsed * std::sqrtf(moisture);
-					victims[rand() % victims.size()]->shake = 0.01f;
-				}
-				else
-				{
-					change_health( - elapsed * ( plant_health_restore_rate + 0.1f ));
-				}
-			}
-			else if( plant_type == corpseeater_plant )
-			{
-				int dead_plants = 0;
-
-				for( int i = 0; i < 4; ++i )
-				{
-					int x = i < 2 ? 2 * i - 1 : 0;
-					int y = i < 2 ? 0 : 2 * ( i - 2 ) - 1;
-					if( grid_x + x >= 0 && grid_x + x < grid.size_x && grid_y + y >= 0 && grid_y + y < grid.size_y )
-					{
-						GroundTile& tile = grid.tiles[grid_x + x][grid_y + y];
-						const PlantType* plant = tile.plant_type;
-						if( plant && tile.is_plant_dead() )
-						{
-							dead_plants++;
-						}
-					}
-				}
-
-				if( dead_plants > 0 )
-				{
-					current_grow_time += grow_power + elapsed * std::sqrtf(moisture);
-				}
-				else
-				{
-					change_health( - elapsed * ( plant_health_restore_rate + 0.1f ));
-				}
-			}
-			else if( plant_type == fireflower_plant )
-			{
-				current_grow_time += grow_power + elapsed;
-			}
-			else if( plant_type == waterflower_plant )
-			{
-				current_grow_time += grow_power + elapsed;
-			}
-			else if ( plant_type == beaconflower_plant ) 
-			{				
-				current_grow_time += grow_power + elapsed;
-			}
-			else if( plant_type == cactus_plant )
-			{
-				if( fire_aura_effect > 0.1f && aqua_aura_effect <= 0.0f )
-				{
-					current_grow_time += grow_power * fire_aura_effect + elapsed;
-				}
-				else
-				{
-					change_health (- elapsed * ( plant_health_restore_rate + 0.1f ));
-				}
-			}
-			else if( plant_type == teleporter_plant )
-			{
-				float target_time = plant_type->get_growth_time();
-				int prev_stage = plant_type->get_growth_stage( current_grow_time / target_time );
-				current_grow_time += grow_power + elapsed;
-				if( prev_stage != plant_type->get_growth_stage( current_grow_time / target_time ) )
-				{
-					std::vector<GroundTile*> potential_targets;
-					for( int x = 0; x < grid.size_x; ++x )
-					{
-						for( int y = 0; y < grid.size_y; ++y )
-						{
-							GroundTile& tile = grid.tiles[x][y];
-							if( x != grid_x || y != grid_y )
-							{
-								if( tile.is_cleared() ) potential_targets.push_back( &tile );
-							}
-						}
-					}
-					if( potential_targets.size() > 0 )
-					{
-						if( try_swap_plants( *this, *potential_targets[rand() % potential_targets.size()] ) )
-						{
-							Sound::play( *teleport_sound, 0.0f, 0.8f );
-						}
-						return;
-					}
-				}
-			}
-			else if( plant_type == spreader_source_plant || plant_type == spreader_child_plant)
-			{
-				// Check if trapped
-				bool trapped = true;
-				for( int i = 0; i < 4; ++i )
-				{
-					int x = i < 2 ? 2 * i - 1 : 0;
-					int y = i < 2 ? 0 : 2 * ( i - 2 ) - 1;
-					if( grid_x + x >= 0 && grid_x + x < grid.size_x && grid_y + y >= 0 && grid_y + y < grid.size_y )
-					{
-						GroundTile& tile = grid.tiles[grid_x + x][grid_y + y];
-						const PlantType* plant = tile.plant_type;
-						if( !plant && tile.is_cleared())
-						{
-							trapped = false;
-						}
-					}
-				}
-
-				// Damage non spreader plants if trapped
-				if( trapped )
-				{
-					for( int i = 0; i < 4; ++i )
-					{
-						int x = i < 2 ? 2 * i - 1 : 0;
-						int y = i < 2 ? 0 : 2 * ( i - 2 ) - 1;
-						if( grid_x + x >= 0 && grid_x + x < grid.size_x && grid_y + y >= 0 && grid_y + y < grid.size_y )
-						{
-							GroundTile& tile = grid.tiles[grid_x + x][grid_y + y];
-							const PlantType* plant = tile.plant_type;
-							if( plant && plant != spreader_child_plant && plant != spreader_source_plant )
-							{
-								tile.change_health( -elapsed * ( plant_health_restore_rate + 0.1f ) );
-							}
-							if( tile.is_plant_dead() )
-							{
-								tile.try_remove_plant();
-							}
-						}
-					}
-				}
-
-				//Spawn new spreaders on growth
-				std::vector<GroundTile*> potential_targets;
-				float target_time = plant_type->get_growth_time();
-				int prev_stage = plant_type->get_growth_stage( current_grow_time / target_time );
-				current_grow_time += grow_power + elapsed;
-				if( prev_stage != plant_type->get_growth_stage( current_grow_time / target_time ) || (is_tile_harvestable() && plant_type == spreader_source_plant ))
-				{
-					for( int i = 0; i < 4; ++i )
-					{
-						int x = i < 2 ? 2 * i - 1 : 0;
-						int y = i < 2 ? 0 : 2 * ( i - 2 ) - 1;
-						if( grid_x + x >= 0 && grid_x + x < grid.size_x && grid_y + y >= 0 && grid_y + y < grid.size_y )
-						{
-							GroundTile& tile = grid.tiles[grid_x + x][grid_y + y];
-							const PlantType* plant = tile.plant_type;
-							if( !plant && tile.is_cleared() )
-							{
-								potential_targets.push_back( &tile );
-							}
-						}
-					}
-
-					if( potential_targets.size() > 0 )
-					{
-						if( potential_targets[rand() % potential_targets.size()]->try_add_plant(spreader_child_plant) )
-						{
-						}
-					}
-				}
-			}
-			// PLANT BEHAVIORS END -----------------------------------------------------------------------------------
-
-			change_health( elapsed * plant_health_restore_rate );
+			visuals.hidden_time += elapsed;
+			continue;
 		}
-
-		fertilization = std::max(0.0f,fertilization - elapsed);
-		if( fertilization > 0.0f ) change_health( elapsed * plant_health_fertilization_restore_rate );
-
-		float target_time = plant_type->get_growth_time();
-		if( current_grow_time > target_time ) current_grow_time = target_time;
-		update_plant_visuals();
+		// growth and scale are read straight from the tile, only the aura dots need the skipped time
+		update_plant_animation( tile, alpha );
+		update_aura_visuals( tile, elapsed + visuals.hidden_time );
+		visuals.hidden_time = 0.0f;
 	}
-
-	// apply fire & aqua aura effect onto neighbors (by putting into pending update)
-	if( plant_type && ( plant_type->get_aura_type()==Aura::fire || plant_type->get_aura_type()==Aura::aqua || plant_type->get_aura_type()==Aura::beacon ) && !is_plant_dead() )
-	{
-		// Beaconflower preprocessing
-		bool fire_apply = fire_aura_effect > 0.1f && fire_aura_effect > aqua_aura_effect;
-		bool water_apply = aqua_aura_effect > 0.1f && aqua_aura_effect > fire_aura_effect;
-
-		auto try_apply_aura = [elapsed, fire_apply, water_apply]( GroundTile& target, Aura::Type aura_type ) {
-			if( target.tile_type->get_can_plant() ) {
-				switch( aura_type ) {
-				case Aura::fire:
-					target.pending_update.fire_aura_effect += 0.2f * elapsed;
-					break;
-				case Aura::aqua:
-					target.pending_update.aqua_aura_effect += 0.2f * elapsed;
-					break;
-				case Aura::beacon:
-					if ( fire_apply ) {
-						target.pending_update.fire_aura_effect += 0.2f * elapsed;
-					} else if ( water_apply ) {
-						target.pending_update.aqua_aura_effect += 0.2f * elapsed;
-					}
-					break;
-				default: // the rest of aura types are decorations only
-					break;
-				}
-			}
-		};
-		// get a list of neighbors
-		std::vector< GroundTile* > neighbors = {};
-		for( int x = -1; x <= 1; x += 2 ) {
-			if( grid_x + x >= 0 && grid_x + x < grid.size_x ) {
-				GroundTile& tile = grid.tiles[grid_x + x][grid_y];
-				neighbors.push_back( &tile );
-			}
-		}
-		for( int y = -1; y <= 1; y += 2 ) {
-			if( grid_y + y >= 0 && grid_y + y < grid.size_y ) {
-				GroundTile& tile = grid.tiles[grid_x][grid_y + y];
-				neighbors.push_back( &tile );
-			}
-		}
-		// apply effect
-		for( auto tile_ptr : neighbors ) {
-			assert( tile_ptr );
-			try_apply_aura( *tile_ptr, plant_type->get_aura_type() );
-		}
-	}
-
-	// update tile state
-	moisture -= moisture_dry_rate * elapsed;
-	fire_aura_effect = std::max( 0.0f, fire_aura_effect - 0.1f * elapsed );
-	aqua_aura_effect = std::max( 0.0f, aqua_aura_effect - 0.1f * elapsed );
 }
 
-void GroundTile::update_plant_visuals()
+void TileGridView::draw_auras( DrawAura& draw_aura )
 {
-	if( plant_type )
+	// sleeping tiles have no auras
+	for( int index : grid->active_tiles )
 	{
-		float percent_grown = current_grow_time / plant_type->get_growth_time();
-		glm::vec3 scale_time_boost = percent_grown < 1.0f ? ( std::sin( plant_time * 4.0f ) * glm::vec3( 0.02f, 0.02f, 0.02f ) ) : glm::vec3(0,0,0);
-		plant_drawable->transform->scale =  scale_time_boost + glm::mix( glm::vec3( 0.5f, 0.5f, 0.5f ), glm::vec3( 1.0f, 1.0f, 1.0f ), plant_type->get_stage_percent( percent_grown ) );
-		const Mesh* plant_mesh = is_plant_dead() ? dead_plant_mesh : plant_type->get_mesh( percent_grown );
-		plant_drawable->pipeline.start = plant_mesh->start;
-		plant_drawable->pipeline.count = plant_mesh->count;
-
-		if( shake > 0.001f )
+		TileVisuals& visuals = tiles[index];
+		if( !visuals.in_view ) continue;
+		for( int aura : { visuals.fire_aura, visuals.aqua_aura, visuals.beacon_aura, visuals.help_aura, visuals.suck_aura } )
 		{
-			plant_drawable->transform->position = plant_position + shake * ( glm::vec3( 2* ( (float)rand() / ( RAND_MAX ) ) , 2 * ( (float)rand() / ( RAND_MAX ) ) , 0 ) - glm::vec3( 1, 1, 0 ) );
+			draw_aura.draw( aura );
 		}
-
-		// set health uniform. TODO: move this to somewhere that gets called less often
-		GLint PROPERTIES_vec3_loc = firstpass_program->PROPERTIES_vec3;
-		plant_drawable->pipeline.set_uniforms = [this, PROPERTIES_vec3_loc](){
-			glUniform3f(PROPERTIES_vec3_loc, plant_health, 0.0f, 0.0f);
-		};
-		if( plant_type->get_aura_type() == Aura::help && is_plant_dead() ) {
-			if( help_aura ) {
-				delete help_aura;
-				help_aura = nullptr;
-			}
-		}
-		if( plant_type->get_aura_type() == Aura::suck && is_plant_dead() ) {
-			if( suck_aura ) {
-				delete suck_aura;
-				suck_aura = nullptr;
-			}
-		}
-		if( plant_type->get_aura_type() == Aura::beacon && is_plant_dead() ) {
-			if( beacon_aura ) {
-				delete beacon_aura;
-				beacon_aura = nullptr;
-			}
-		}
-	}
-	else
-	{
-		plant_drawable->pipeline.start = 0;
-		plant_drawable->pipeline.count = 0;
 	}
 }
 
-void GroundTile::apply_pending_update(float elapsed)
+void TileGridView::on_tile_type_changed( GroundTile& tile )
 {
-	// move update from pending_update
-	fire_aura_effect = std::min( 1.0f, fire_aura_effect + pending_update.fire_aura_effect );
-	aqua_aura_effect = std::min( 1.0f, aqua_aura_effect + pending_update.aqua_aura_effect );
-	pending_update.fire_aura_effect = 0.0f;
-	pending_update.aqua_aura_effect = 0.0f;
-
-	//.. and continue updating what's left
-	moisture += aqua_aura_effect * elapsed * 0.25f;
-	moisture -= fire_aura_effect * elapsed * 0.25f;
-
-	moisture = std::max( 0.0f, moisture );
-	moisture = std::min( 1.0f, moisture );
-	
+	TileVisuals& visuals = tiles[tile.index];
+	Mesh const* mesh = get_tile_mesh( tile.tile_type );
+	visuals.tile_drawable->pipeline.start = mesh->start;
+	visuals.tile_drawable->pipeline.count = mesh->count;
+	visuals.tile_drawable->bounds_min = mesh->min;
+	visuals.tile_drawable->bounds_max = mesh->max;
+	update_properties( tile );
 }
 
-void GroundTile::update_aura_visuals( float elapsed, Scene::Transform* camera_transform )
-{ // TODO: always have aura created but only update when there is effect?
-	// create corresponding aura if not already exist
-	if( fire_aura_effect > 0 && (!fire_aura) ) {
-		fire_aura = new Aura( tile_drawable->transform->position, Aura::fire );
-	}
-	if( aqua_aura_effect > 0 && (!aqua_aura) ) {
-		aqua_aura = new Aura( tile_drawable->transform->position, Aura::aqua );
-	}
-	// or delete if no longer has aura effect	
-	if( fire_aura_effect == 0 && fire_aura ) {
-		delete fire_aura;
-		fire_aura = nullptr;
-	}
-	if( aqua_aura_effect == 0 && aqua_aura ) {
-		delete aqua_aura;
-		aqua_aura = nullptr;
-	}
-	// update aura accordingly
-	if( fire_aura ) fire_aura->update( 
-			int(floor(fire_aura_effect * fire_aura->max_strength)), // strength
-			elapsed, camera_transform );
-	if( aqua_aura ) aqua_aura->update( 
-			int(floor(aqua_aura_effect * aqua_aura->max_strength)), // strength
-			elapsed, camera_transform );
-
-	if( help_aura ) help_aura->update( help_aura->max_strength, elapsed, camera_transform );
-	if( suck_aura ) suck_aura->update( suck_aura->max_strength, elapsed, camera_transform );
-	if ( beacon_aura ) beacon_aura->update( beacon_aura->max_strength, elapsed, camera_transform );
-}
-
-bool GroundTile::try_swap_plants(GroundTile& tile_a, GroundTile& tile_b )
+void TileGridView::update_properties( GroundTile& tile )
 {
-	if( tile_a.is_cleared() && tile_b.is_cleared() )
-	{
-		const PlantType* swap_type = tile_b.plant_type;
-		float swap_health = tile_b.plant_health;
-		float swap_growth_time = tile_b.current_grow_time;
-		tile_b.plant_type = tile_a.plant_type;
-		tile_b.plant_health = tile_a.plant_health;
-		tile_b.current_grow_time = tile_a.current_grow_time;
-		tile_a.plant_type = swap_type;
-		tile_a.plant_health = swap_health;
-		tile_a.current_grow_time = swap_growth_time;
-		tile_a.update_plant_visuals();
-		tile_b.update_plant_visuals();
-		return true;
-	}
-	return false;
+	TileVisuals& visuals = tiles[tile.index];
+	float moisture = tile.tile_type && tile.tile_type->get_can_plant() ? tile.moisture() : 0.0f;
+	visuals.tile_drawable->pipeline.properties = glm::vec3( 1.0f, moisture, 0.0f );
+	visuals.plant_drawable->pipeline.properties = glm::vec3( tile.plant_type ? tile.plant_health() : 1.0f, 0.0f, 0.0f );
 }
 
-bool GroundTile::try_add_plant( const PlantType* plant_type_in )
+void TileGridView::on_plant_changed( GroundTile& tile )
 {
-	// If we can plant on the tile and there is no plant already there, add a plant
-	if( can_plant() )
-	{
-		if( !plant_type || try_remove_plant() )
-		{
-			plant_type = plant_type_in;
-			plant_drawable->pipeline.start = plant_type->get_mesh( 0.0f )->start;
-			plant_drawable->pipeline.count = plant_type->get_mesh( 0.0f )->count;
-
-			current_grow_time = 0.0f;
-			plant_health = 1.0f;
-			update_plant_visuals();
-			if( plant_type->get_aura_type() == Aura::help ) {
-				help_aura = new Aura( tile_drawable->transform->position, Aura::help, 4 );
-			}
-			else if( plant_type->get_aura_type() == Aura::suck ) {
-				suck_aura = new Aura( tile_drawable->transform->position, Aura::suck, 6 );
-			}
-			else if( plant_type->get_aura_type() == Aura::beacon ) {
-				beacon_aura = new Aura( tile_drawable->transform->position, Aura::beacon, 4 );
-			}
-			return true;
-		}
-	}
-	return false;
+	update_plant_visuals( tile );
 }
 
-bool GroundTile::try_remove_plant()
+void TileGridView::on_aura_changed( GroundTile& tile )
 {
-	// If there is a plant on tile, kick it out and hide the drawable
-	if( plant_type )
-	{
-		if( plant_type->get_aura_type() == Aura::help && help_aura ) {
-			delete help_aura;
-			help_aura = nullptr;
-		}
-		if( plant_type->get_aura_type() == Aura::suck && suck_aura ) {
-			delete suck_aura;
-			suck_aura = nullptr;
-		}
-		if ( plant_type->get_aura_type() == Aura::beacon && beacon_aura ) {
-			delete beacon_aura;
-			beacon_aura = nullptr;
+	TileVisuals& visuals = tiles[tile.index];
+	auto sync_aura = [&visuals]( int& aura, AuraKind::Type type, float effect ) {
+		if( effect > 0.0f && aura < 0 ) {
+			aura = aura_particles.add_emitter( visuals.tile_drawable->transform->get_position(), type );
+		} else if( effect <= 0.0f && aura >= 0 ) {
+			aura_particles.remove_emitter( aura );
+			aura = -1;
 		}
-		plant_type = nullptr;
-		update_plant_visuals();
-		return true;
-	}
-	return false;
+	};
+	sync_aura( visuals.fire_aura, AuraKind::fire, tile.fire_aura_effect() );
+	sync_aura( visuals.aqua_aura, AuraKind::aqua, tile.aqua_aura_effect() );
 }
 
-bool GroundTile::is_tile_harvestable()
+void TileGridView::on_tile_asleep( GroundTile& tile )
 {
-	return plant_type && current_grow_time >= plant_type->get_growth_time() && !is_plant_dead();
+	// no plant and no aura effect left, and its moisture as it settled
+	remove_all_auras( tile.index );
+	update_properties( tile );
 }
 
-bool GroundTile::is_plant_dead()
+void TileGridView::on_plant_died( GroundTile& tile )
 {
-	return plant_type && plant_health <= 0.0f;
+	// skipped time stays quiet
+	if( grid->fast_forwarding ) return;
+	Sound::play( *plant_death_sound, 0.0f, 1.0f );
 }
 
-bool GroundTile::can_plant()
+void TileGridView::on_teleport( GroundTile& from, GroundTile& to )
 {
-	return tile_type->get_can_plant() && (!plant_type || is_plant_dead());
+	if( grid->fast_forwarding ) return;
+	Sound::play( *teleport_sound, 0.0f, 0.8f );
 }
 
-bool GroundTile::can_be_cleared(const TileGrid& grid ) const
+void TileGridView::update_plant_visuals( GroundTile& tile )
 {
-	bool has_cleared_neighbor = false;
-	for( int i = 0; i < 4; ++i )
-	{
-		int x_i = i < 2 ? 2*i - 1 : 0;
-		int y_i = i < 2 ? 0 : 2 * ( i - 2 ) - 1;
-		if( grid.is_in_grid( grid_x + x_i, grid_y + y_i ) && grid.tiles[grid_x + x_i][grid_y + y_i].is_cleared() )
-		{
-			has_cleared_neighbor = true;
-			break;
+	TileVisuals& visuals = tiles[tile.index];
+	const PlantType* plant_type = tile.plant_type;
+
+	// plant auras follow whatever living plant is on the tile
+	AuraKind::Type plant_aura = plant_type && !tile.is_plant_dead() ? plant_type->get_aura_type() : AuraKind::none;
+	auto sync_aura = [&visuals, plant_aura]( int& aura, AuraKind::Type type, int max_strength ) {
+		if( plant_aura == type && aura < 0 ) {
+			aura = aura_particles.add_emitter( visuals.tile_drawable->transform->get_position(), type, max_strength );
+		} else if( plant_aura != type && aura >= 0 ) {
+			aura_particles.remove_emitter( aura );
+			aura = -1;
 		}
-	}
+	};
+	sync_aura( visuals.help_aura, AuraKind::help, 4 );
+	sync_aura( visuals.suck_aura, AuraKind::suck, 6 );
+	sync_aura( visuals.beacon_aura, AuraKind::beacon, 4 );
 
-	return has_cleared_neighbor && tile_type->get_clear_cost() > 0;
+	if( plant_type )
+	{
+		const Mesh* plant_mesh = tile.is_plant_dead() ? dead_plant_mesh : get_plant_look( plant_type ).get_mesh( grid->plant_stage[tile.index] );
+		visuals.plant_drawable->pipeline.start = plant_mesh->start;
+		visuals.plant_drawable->pipeline.count = plant_mesh->count;
+		visuals.plant_drawable->bounds_min = plant_mesh->min;
+		visuals.plant_drawable->bounds_max = plant_mesh->max;
+		update_properties( tile );
+		update_plant_animation( tile, 1.0f );
+	}
+	else
+	{
+		visuals.plant_drawable->pipeline.start = 0;
+		visuals.plant_drawable->pipeline.count = 0;
+	}
 }
 
-bool GroundTile::try_clear_tile()
+void TileGridView::update_plant_animation( GroundTile& tile, float alpha )
 {
-	change_tile_type( ground_tile );
-	return true;
-}
+	if( !tile.plant_type ) return;
+	TileVisuals& visuals = tiles[tile.index];
 
-bool GroundTile::is_cleared() const
-{
-	return tile_type == ground_tile;
-}
+	// grown plants hold still unless shaken
+	float grow_time = glm::mix( grid->previous_grow_time[tile.index], tile.current_grow_time(), alpha );
+	float percent_grown = grow_time / tile.plant_type->get_growth_time();
+	if( percent_grown < 1.0f )
+	{
+		glm::vec3 scale_time_boost = std::sin( time * 4.0f ) * glm::vec3( 0.02f, 0.02f, 0.02f );
+		visuals.plant_drawable->transform->set_scale( scale_time_boost + glm::mix( glm::vec3( 0.5f, 0.5f, 0.5f ), glm::vec3( 1.0f, 1.0f, 1.0f ), tile.plant_type->get_stage_percent( percent_grown ) ) );
+	}
+	else
+	{
+		visuals.plant_drawable->transform->set_scale( glm::vec3( 1.0f, 1.0f, 1.0f ) );
+	}
 
-void GroundTile::change_health( float change )
-{
-	if( plant_type && !is_plant_dead() )
+	if( tile.shake > 0.001f )
 	{
-		float prev_health = plant_health;
-		(void) prev_health;
-		plant_health = glm::clamp( plant_health + change, 0.0f, 1.0f );
-		if( is_plant_dead() ) Sound::play( *plant_death_sound, 0.0f, 1.0f );
+		visuals.plant_drawable->transform->set_position( visuals.plant_position + tile.shake * ( glm::vec3( 2 * shake_random.next_float(), 2 * shake_random.next_float(), 0 ) - glm::vec3( 1, 1, 0 ) ) );
 	}
 }
 
-bool TileGrid::is_in_grid( int x, int y ) const
+void TileGridView::update_aura_visuals( GroundTile& tile, float elapsed )
 {
-	return x >= 0 && y >= 0 && x < size_x && y < size_y;
+	// on_aura_changed creates and removes the fire and aqua auras, this only animates them
+	TileVisuals& visuals = tiles[tile.index];
+	if( visuals.fire_aura >= 0 ) {
+		int strength = int( std::floor( tile.fire_aura_effect() * aura_particles.get_max_strength( visuals.fire_aura ) ) );
+		aura_particles.update_emitter( visuals.fire_aura, strength, elapsed );
+	}
+	if( visuals.aqua_aura >= 0 ) {
+		int strength = int( std::floor( tile.aqua_aura_effect() * aura_particles.get_max_strength( visuals.aqua_aura ) ) );
+		aura_particles.update_emitter( visuals.aqua_aura, strength, elapsed );
+	}
+	for( int aura : { visuals.help_aura, visuals.suck_aura, visuals.beacon_aura } ) {
+		if( aura >= 0 ) aura_particles.update_emitter( aura, aura_particles.get_max_strength( aura ), elapsed );
+	}
+}
+
+void TileGridView::remove_all_auras( int index ) {
+	TileVisuals& visuals = tiles[index];
+	for( int* aura : { &visuals.help_aura, &visuals.suck_aura, &visuals.beacon_aura, &visuals.fire_aura, &visuals.aqua_aura } ) {
+		if( *aura >= 0 ) {
+			aura_particles.remove_emitter( *aura );
+			*aura = -1;
+		}
+	}
 }
 
-void PlantType::make_menu_items(const PlantType** selectedPlant, Tool* current_tool,
-		UIElem** seed_item, UIElem** harvest_item ) const {
+void make_plant_menu_items( PlantType const* plant, const PlantType** selectedPlant, Tool* current_tool,
+		UIElem** seed_item, UIElem** harvest_item ) {
+	PlantLook const& look = get_plant_look( plant );
+	Sprite const* seed_sprite = look.seed_sprite;
+	Sprite const* harvest_sprite = look.harvest_sprite;
 	assert( selectedPlant );
 	assert( seed_item );
 	assert( harvest_item );
@@ -894,15 +523,15 @@ void PlantType::make_menu_items(const PlantType** selectedPlant, Tool* current_t
 		glm::vec2(0, 5), // pos
 		glm::vec2(64, 64),
 		seed_sprite, // sprite,
-		name + " seed",
+		plant->get_name() + " seed",
 		glm::vec2(32, 32),
 		0.3f, true);
-	(*seed_item)->set_on_mouse_down([this, selectedPlant, current_tool](){
-		if( *current_tool == seed && *selectedPlant == this ) {
+	(*seed_item)->set_on_mouse_down([plant, selectedPlant, current_tool](){
+		if( *current_tool == seed && *selectedPlant == plant ) {
 			*selectedPlant = nullptr;
 			*current_tool = default_hand;
 		} else {
-			*selectedPlant = this;
+			*selectedPlant = plant;
 			*current_tool = seed;
 		}
 	});
@@ -913,34 +542,7 @@ void PlantType::make_menu_items(const PlantType** selectedPlant, Tool* current_t
 		glm::vec2(0, 5),
 		glm::vec2(64, 64),
 		harvest_sprite,
-		name,
+		plant->get_name(),
 		glm::vec2(32, 32),
 		0.4f);
 }
-
-void GroundTile::remove_all_auras() {
-	if( help_aura ) {
-		delete help_aura;
-		help_aura = nullptr;
-	}
-	if( suck_aura ) {
-		delete suck_aura;
-		suck_aura = nullptr;
-	}
-	if( beacon_aura ) {
-		delete beacon_aura;
-		beacon_aura = nullptr;
-	}
-	if( fire_aura ) {
-		delete fire_aura;
-		fire_aura = nullptr;
-	}
-	if( aqua_aura ) {
-		delete aqua_aura;
-		aqua_aura = nullptr;
-	}
-	fire_aura_effect = 0.0f;
-	aqua_aura_effect = 0.0f;
-	pending_update.fire_aura_effect = 0.0f;
-	pending_update.aqua_aura_effect = 0.0f;
-}
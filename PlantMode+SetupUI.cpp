@@ -672,7 +672,7 @@ void PlantMode::setup_UI() {
 	auto add_plant_buttons = [this, seed_tab_items, harvest_tab_items, seed_name_text, seed_description_text](PlantType const* plant) {
 		UIElem* seed_icon = nullptr;
 		UIElem* harvest_icon = nullptr;
-		plant->make_menu_items(&selectedPlant, &current_tool, &seed_icon, &harvest_icon);
+		make_plant_menu_items(plant, &selectedPlant, &current_tool, &seed_icon, &harvest_icon);
 		assert(seed_icon); assert(harvest_icon);
 		seed_icon->set_on_mouse_enter([plant, seed_name_text, seed_description_text](){
 			seed_name_text->set_text( plant->get_name() + " :" );
@@ -829,7 +829,7 @@ void PlantMode::setup_UI() {
 	// magicbook buy choices
 	auto add_buy_choice = [this, all_choices]( PlantType const* plant ) {
 		UIElem* entry = new UIElem(all_choices); // will get automatically laid out anyway
-		plant_to_magicbook_entry.insert( std::make_pair( plant, entry ) ); //used for unlocking plants
+		plant_to_magicbook_entry[plant->get_id()] = entry; //used for unlocking plants
 
 		UIElem* lock = new UIElem( entry ); 
 		lock->set_sprite( ui_sprites.magicbook.lock );
@@ -838,13 +838,13 @@ void PlantMode::setup_UI() {
 
 		// icon
 		UIElem* icon = new UIElem(entry);
-		icon->set_sprite(plant->get_harvest_sprite());
+		icon->set_sprite(get_plant_look(plant).harvest_sprite);
 		icon->set_scale(0.5f);
 		icon->hide();
 
 		// seed
 		UIElem* seed = new UIElem(entry);
-		seed->set_sprite(plant->get_seed_sprite());
+		seed->set_sprite(get_plant_look(plant).seed_sprite);
 		seed->set_scale(0.25f);
 		seed->set_position(glm::vec2(0, 60), glm::vec2(0, 0));
 		seed->hide();
@@ -875,11 +875,7 @@ void PlantMode::setup_UI() {
 		buy->set_tint( text_tint );
 		buy->set_scale( 0.6f );
 		buy->set_on_mouse_down( [this, plant](){
-			if( num_coins >= plant->get_cost() ){
-				Sound::play( *magic_book_purchase_sound, 0.0f, 1.0f );
-				change_num_coins( -plant->get_cost() );
-				inventory.change_seeds_num( plant, 1 );
-			}
+			buy_seed( plant );
 		} );
 		buy->set_on_mouse_enter( [buy, this](){
 			buy->set_tint( text_highlight_tint );
@@ -981,47 +977,7 @@ void PlantMode::setup_UI() {
 	complete_btn->set_on_mouse_enter([this, complete_btn](){ complete_btn->set_tint(text_highlight_tint); });
 	complete_btn->set_on_mouse_leave([this, complete_btn](){ complete_btn->set_tint(text_tint); });
 	complete_btn->set_on_mouse_down([this](){
-		std::map< PlantType const*, int > require_plants = current_main_order->get_required_plants();
-		bool orderFinished = true;
-		std::map<PlantType const*, int>::iterator iter = require_plants.begin();
-		while( iter != require_plants.end() ) {
-			PlantType const* require_type = iter->first;
-			int needed_num = iter->second;
-			if( inventory.get_harvest_num(require_type) < needed_num ){
-				orderFinished = false;
-				break;
-			}
-			iter++;
-		}
-		std::cout << orderFinished << std::endl;
-		if( orderFinished == true ){
-			iter = require_plants.begin();
-			while( iter != require_plants.end() ) {
-				PlantType const* require_type = iter->first;
-				int needed_num = iter->second;
-				inventory.change_harvest_num(require_type, -needed_num);
-				iter++;
-			}
-
-			if( current_main_order->get_bonus_plant() ) unlock_plant( current_main_order->get_bonus_plant() );
-
-			Sound::play( *order_completed_sound, 0.0f, 1.0f );
-			change_num_coins( current_main_order->get_bonus_cash() );
-			current_main_order_idx += 1;
-			if( current_main_order_idx >= main_orders.size() ){
-				current_main_order_idx = (int)main_orders.size()-1;
-				gameover = true;
-				UI.root->hide();
-				UI.root_gameover->show();
-				UI.win_screen->show();
-				UI.lose_screen->hide();
-			}
-			else
-			{
-				// std::cout << "main_order_idx " << current_main_order_idx << std::endl;
-				set_main_order( current_main_order_idx );
-			}
-		}
+		state.complete_order( GameState::main_order_slot );
 	});
 
 	UI.main_order.unlock_plant = new UIElem(
@@ -1104,36 +1060,7 @@ void PlantMode::setup_UI() {
 	complete_btn->set_on_mouse_enter([this, complete_btn](){ complete_btn->set_tint(text_highlight_tint); });
 	complete_btn->set_on_mouse_leave([this, complete_btn](){ complete_btn->set_tint(text_tint); });
 	complete_btn->set_on_mouse_down([this](){
-		// std::cout << "Submit Button Click!" << std::endl;
-		std::map< PlantType const*, int > require_plants = current_daily_order->get_required_plants();
-		bool orderFinished = true;
-		std::map<PlantType const*, int>::iterator iter = require_plants.begin();
-		while( iter != require_plants.end() ) {
-			PlantType const* require_type = iter->first;
-			int needed_num = iter->second;
-			if( inventory.get_harvest_num(require_type) < needed_num ){
-				orderFinished = false;
-				break;
-			}
-			iter++;
-		}
-		std::cout << orderFinished << std::endl;
-		if( orderFinished == true ){
-			iter = require_plants.begin();
-			while( iter != require_plants.end() ) {
-				PlantType const* require_type = iter->first;
-				int needed_num = iter->second;
-				inventory.change_harvest_num(require_type, -needed_num);
-				iter++;
-			}
-			Sound::play( *order_completed_sound, 0.0f, 1.0f );
-			change_num_coins( current_daily_order->get_bonus_cash() );
-			current_daily_order_idx += 1;
-			if( current_daily_order_idx >= daily_orders.size() ){
-				current_daily_order_idx = 0;
-			}
-			set_daily_order(current_daily_order_idx);
-		}
+		state.complete_order( GameState::daily_order_slot );
 	});
 
 	/*UIElem* cancel_btn = new UIElem(
@@ -1189,3 +1116,14 @@ void PlantMode::setup_UI() {
 		}
 	});
 }
+
+bool PlantMode::buy_seed( PlantType const* plant )
+{
+	if( !state.buy_seed( plant ) ) return false;
+	Sound::play( *magic_book_purchase_sound, 0.0f, 1.0f );
+	return true;
+}
+
+void PlantMode::on_order_completed( int slot ) {
+	Sound::play( *order_completed_sound, 0.0f, 1.0f );
+}
@@ -0,0 +1,110 @@
+#include "PlantMode.hpp"
+#include "read_write_chunk.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+// Game snapshot, in read_write_chunk.hpp chunks:
+//  gam0 header | sed0, hrv0 seeds and harvests per plant | unl0 unlocked flag per plant (all in all_plants order)
+//  isl0 clock per island, followed by each island's grid chunks in order (see TileGrid::write_snapshot)
+struct GameSnapshotHeader
+{
+	uint32_t version = 0;
+	int32_t num_coins = 0;
+	int32_t main_order_idx = 0;
+	int32_t daily_order_idx = 0;
+};
+static_assert( sizeof( GameSnapshotHeader ) == 16, "header is packed" );
+
+static constexpr uint32_t game_snapshot_version = 2;
+
+void PlantMode::save_snapshot( std::ostream* to )
+{
+	GameSnapshotHeader header;
+	header.version = game_snapshot_version;
+	header.num_coins = state.num_coins;
+	header.main_order_idx = state.current_main_order_idx;
+	header.daily_order_idx = state.current_daily_order_idx;
+	write_chunk( "gam0", std::vector< GameSnapshotHeader >{ header }, to );
+
+	std::vector< int32_t > seeds;
+	std::vector< int32_t > harvests;
+	std::vector< uint8_t > unlocked;
+	for( PlantType const* plant : all_plants )
+	{
+		seeds.emplace_back( state.get_seeds_num( plant ) );
+		harvests.emplace_back( state.get_harvest_num( plant ) );
+		unlocked.emplace_back( state.is_unlocked( plant ) );
+	}
+	write_chunk( "sed0", seeds, to );
+	write_chunk( "hrv0", harvests, to );
+	write_chunk( "unl0", unlocked, to );
+
+	std::vector< float > clocks;
+	for( auto const& island : world.islands ) clocks.emplace_back( island->clock );
+	write_chunk( "isl0", clocks, to );
+	for( auto const& island : world.islands ) island->grid.write_snapshot( to );
+}
+
+void PlantMode::load_snapshot( std::istream& from )
+{
+	// read and check everything first, so a broken file throws before anything changed
+	std::vector< GameSnapshotHeader > header;
+	std::vector< int32_t > seeds;
+	std::vector< int32_t > harvests;
+	std::vector< uint8_t > unlocked;
+	read_chunk( from, "gam0", &header );
+	if( header.size() != 1 || header[0].version != game_snapshot_version )
+	{
+		throw std::runtime_error( "Unsupported game snapshot version" );
+	}
+	if( header[0].main_order_idx < 0 || size_t( header[0].main_order_idx ) >= main_orders.size()
+		|| header[0].daily_order_idx < 0 || size_t( header[0].daily_order_idx ) >= daily_orders.size() )
+	{
+		throw std::runtime_error( "Game snapshot has an order out of range" );
+	}
+	read_chunk( from, "sed0", &seeds );
+	read_chunk( from, "hrv0", &harvests );
+	read_chunk( from, "unl0", &unlocked );
+	if( seeds.size() != all_plants.size() || harvests.size() != all_plants.size() || unlocked.size() != all_plants.size() )
+	{
+		throw std::runtime_error( "Game snapshot has the wrong plant count" );
+	}
+
+	std::vector< float > clocks;
+	read_chunk( from, "isl0", &clocks );
+	if( clocks.size() != world.islands.size() )
+	{
+		throw std::runtime_error( "Game snapshot has the wrong island count" );
+	}
+
+	std::vector< GridSnapshot > grids( world.islands.size() );
+	for( size_t i = 0; i < world.islands.size(); ++i )
+	{
+		world.islands[i]->grid.read_snapshot( from, &grids[i] );
+	}
+
+	for( GroundTile& tile : grid->tiles )
+	{
+		grid_view.remove_all_auras( tile.index );
+	}
+	for( size_t i = 0; i < world.islands.size(); ++i )
+	{
+		world.islands[i]->grid.apply_snapshot( grids[i] );
+		world.islands[i]->clock = clocks[i];
+	}
+
+	for( size_t i = 0; i < all_plants.size(); ++i )
+	{
+		PlantType const* plant = all_plants[i];
+		if( unlocked[i] ) state.unlock_plant( plant );
+		else state.lock_plant( plant );
+		state.change_seeds_num( plant, seeds[i] - state.get_seeds_num( plant ) );
+		state.change_harvest_num( plant, harvests[i] - state.get_harvest_num( plant ) );
+	}
+	state.set_main_order( header[0].main_order_idx );
+	state.set_daily_order( header[0].daily_order_idx );
+
+	state.outcome = GameState::playing;
+	state.num_coins = header[0].num_coins;
+	state.change_num_coins( 0 );
+}
@@ -12,6 +12,7 @@
 #include "collide.hpp"
 #include "DrawSprites.hpp"
 #include "Sound.hpp"
+#include "WorkerPool.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -20,13 +21,13 @@
 #include <fstream>
 #include <sstream>
 #include <map>
+#include <algorithm>
 #include <cstddef>
 #include <random>
 #include <unordered_map>
 
-TileGrid grid;
-int plant_grid_x = 10;
-int plant_grid_y = 10;
+int plant_grid_x = starting_island_size;
+int plant_grid_y = starting_island_size;
 
 Mesh const* selector_mesh = nullptr;
 
@@ -75,9 +76,19 @@ Load< GLuint > ui_meshes_for_firstpass_program( LoadTagDefault, [](){
 	return new GLuint( ui_meshes->make_vao_for_program( firstpass_program->program ) );
 } );
 
-PlantMode::PlantMode() 
+PlantMode::PlantMode( int island_count ) 
 {
-	grid = setup_grid_for_scene( scene, plant_grid_x, plant_grid_y );
+	state.observer = this;
+	world.workers = &workers;
+	world.step = sim_step;
+	world.max_backlog = max_sim_backlog;
+	world.beacon_aura_radius = beacon_aura_radius;
+	for( int i = 0; i < std::max( 1, island_count ); ++i )
+	{
+		state.order_tracker.track( world.add_island( plant_grid_x, plant_grid_y ).grid );
+	}
+	grid = &world.get_visible().grid;
+	grid_view.setup( *grid, scene );
 
 	// Sound::loop(*background_music, 0.0f, 1.0f);
 	Sound::loop( *land_ambience, 0.0f, 0.85f );
@@ -97,7 +108,7 @@ PlantMode::PlantMode()
 		//Create a selector mesh
 		scene.transforms.emplace_back();
 		Scene::Transform* selector_transform = &scene.transforms.back();
-		selector_transform->position = glm::vec3();
+		selector_transform->set_position( glm::vec3() );
 		scene.drawables.emplace_back( selector_transform );
 		selector = &scene.drawables.back();
 
@@ -106,7 +117,14 @@ PlantMode::PlantMode()
 		selector_info.vao = *ui_meshes_for_firstpass_program;
 		selector_info.start = selector_mesh->start;
 		selector_info.count = selector_mesh->count;
+		// full health, dry: the tiles don't leave their PROPERTIES behind any more (they're drawn instanced)
+		GLint PROPERTIES_vec3_loc = firstpass_program->PROPERTIES_vec3;
+		selector_info.set_uniforms = [PROPERTIES_vec3_loc](){
+			glUniform3f(PROPERTIES_vec3_loc, 1.0f, 0.0f, 0.0f);
+		};
 		selector->pipeline = selector_info;
+		selector->bounds_min = selector_mesh->min;
+		selector->bounds_max = selector_mesh->max;
 	}
 	
 	{ //make a camera:
@@ -117,13 +135,13 @@ PlantMode::PlantMode()
 		float se = std::sin( camera_elevation );
 		float ca = std::cos( camera_azimuth );
 		float sa = std::sin( camera_azimuth );
-		transform->position = camera_radius * glm::vec3( ce * ca, ce * sa, se );
-		transform->rotation =
+		transform->set_position( camera_radius * glm::vec3( ce * ca, ce * sa, se ) );
+		transform->set_rotation(
 			glm::quat_cast( glm::transpose( glm::mat3( glm::lookAt(
-			transform->position,
+			transform->get_position(),
 			glm::vec3( 0.0f, 0.0f, 0.0f ),
 			glm::vec3( 0.0f, 0.0f, 1.0f )
-			) ) ) );
+			) ) ) ) );
 
 		scene.cameras.emplace_back(transform);
 		camera = &scene.cameras.back();
@@ -131,17 +149,17 @@ PlantMode::PlantMode()
 		camera->fovy = glm::radians(45.0f);
 	}
 
-	forward_camera_dir = camera->transform->rotation * glm::vec3( 0.0f, 0.0f, -1.0f );
+	forward_camera_dir = camera->transform->get_rotation() * glm::vec3( 0.0f, 0.0f, -1.0f );
 	forward_dir = glm::normalize( glm::vec3( forward_camera_dir.x, forward_camera_dir.y, 0.0f ) );
 
-	side_camera_dir = camera->transform->rotation * glm::vec3( 1.0f, 0.0f, 0.0f );
+	side_camera_dir = camera->transform->get_rotation() * glm::vec3( 1.0f, 0.0f, 0.0f );
 	side_dir = glm::normalize( glm::vec3( side_camera_dir.x, side_camera_dir.y, 0.0f ) );
 
 	{ // make sea
 		water.transforms.emplace_back();
 		Scene::Transform* sea_transform = &water.transforms.back();
-		sea_transform->position = glm::vec3();
-		sea_transform->scale = glm::vec3( 40, 40, 1 );
+		sea_transform->set_position( glm::vec3() );
+		sea_transform->set_scale( glm::vec3( 40, 40, 1 ) );
 		water.drawables.emplace_back( sea_transform );
 		sea = &water.drawables.back();
 
@@ -161,13 +179,6 @@ PlantMode::PlantMode()
 }
 
 PlantMode::~PlantMode() {
-	for (int i=0; i<grid.size_x; i++) {
-		for (int j=0; j<grid.size_y; j++) {
-			GroundTile& tile = grid.tiles[i][j];
-			if( tile.fire_aura ) delete tile.fire_aura;
-			if( tile.aqua_aura ) delete tile.aqua_aura;
-		}
-	}
 	if (UI.root) delete UI.root;
 	if( UI.root_pause ) delete UI.root_pause;
 	if (UI.root_title) delete UI.root_title;
@@ -178,82 +189,65 @@ void PlantMode::reset_game()
 	set_current_tool( default_hand );
 	UI.root->show();
 	UI.root_gameover->hide();
+	for( auto& island : world.islands ) island->accumulator = 0.0f;
 
-	// Reset Inventory
+	// the first game gets built tile by tile, later resets just copy it back
+	if( reset_snapshot.empty() )
 	{
-		num_coins = 30;
-		change_num_coins( 0 );
-
-		for( auto p : all_plants )
-		{
-			lock_plant( p );
-			inventory.change_seeds_num( p, -inventory.get_seeds_num( p ) );
-			inventory.change_harvest_num( p, -inventory.get_harvest_num( p ) );
-		}
-		unlock_plant( test_plant );
-		inventory.change_seeds_num( test_plant, 5 );
+		setup_new_game();
+		std::ostringstream snapshot;
+		save_snapshot( &snapshot );
+		reset_snapshot = snapshot.str();
+	}
+	else
+	{
+		std::istringstream snapshot( reset_snapshot );
+		load_snapshot( snapshot );
 	}
 
+	// Show title
+	paused = true;
+	title = true;
+	gameover = false;
+}
+
+void PlantMode::setup_new_game()
+{
+	// Reset Inventory and Orders
+	state.reset();
+
 	// Reset Island
 	{
-		std::string island =
-			"oodddddooo"
-			"oddxXxxddo"
-			"dxxXXXxxdo"
-			"odxxXxxxdd"
-			"dxxxCCxxxd"
-			"dxxxCCxxxd"
-			"dxxxxxxxdo"
-			"odxxXXxdoo"
-			"odxdxXXxdo"
-			"oododdddoo";
-
-		// Create a lil center island
+		// Create a lil center island (every island of the world starts out the same)
+		for( auto& island : world.islands )
 		{
+			island->clock = 0.0f;
 			for( int32_t x = 0; x < plant_grid_x; ++x )
 			{
 				for( int32_t y = 0; y < plant_grid_y; ++y )
 				{
-					grid.tiles[x][y].try_remove_plant();
-					const GroundTileType* type = empty_tile;
-					if( island[x + y * plant_grid_x] == 'x' )
-					{
-						type = grass_short_tile;
-					}
-					else if( island[x + y * plant_grid_x] == 'X' )
-					{
-						type = grass_tall_tile;
-					}
-					else if( island[x + y * plant_grid_x] == 'd' )
-					{
-						type = dirt_tile;
-					}
-					else if( island[x + y * plant_grid_x] == 'C' )
-					{
-						type = ground_tile;
-					}
-					grid.tiles[x][y].change_tile_type( type );
+					GroundTile& tile = island->grid.get_tile( x, y );
+					tile.try_remove_plant();
+					const GroundTileType* type = get_island_tile_type( starting_island[x + y * plant_grid_x] );
+					tile.clear_auras();
+					if( &island->grid == grid ) grid_view.remove_all_auras( tile.index );
+					tile.change_tile_type( type );
 
 					// init tile properties
-					grid.tiles[x][y].moisture = 1.0f;
-					grid.tiles[x][y].remove_all_auras();
+					tile.moisture() = 1.0f;
 				}
 			}
 		}
 	}
+}
 
-	// Reset Orders
-	{
-		current_main_order_idx = 0;
-		current_daily_order_idx = 0;
-		set_main_order( current_main_order_idx );
-		set_daily_order( current_daily_order_idx );
-	}
-
-	// Show title
-	paused = true;
-	title = true;
-	gameover = false;
+void PlantMode::show_island( int index )
+{
+	if( index == world.visible ) return;
+	grid_view.clear( scene );
+	world.show( index );
+	grid = &world.get_visible().grid;
+	grid_view.setup( *grid, scene );
 }
 
 void PlantMode::on_click( int x, int y )
@@ -273,78 +267,49 @@ void PlantMode::on_click( int x, int y )
 	}
 	//---- Otherwise, detect click on tiles.
 	GroundTile* collided_tile = get_tile_under_mouse( x, y );
+	if( collided_tile ) use_tool( collided_tile );
+}
 
-	if( collided_tile ) {
-
-		if( current_tool == default_hand ) {
-			if( collided_tile->plant_type ) {
-				// Harvesting plant
-				if( collided_tile->is_tile_harvestable() ) {
-					PlantType const* plant = collided_tile->plant_type;
-					if( collided_tile->try_remove_plant() ) {
-						Sound::play( *harvest_sound, 0.0f, 2.0f );
-						assert( plant );
-						inventory.change_harvest_num( plant, 1 );
-					}
-				}
-
-				else if( collided_tile->is_plant_dead() ) {
-					Sound::play( *harvest_sound, 0.0f, 2.0f );
-					collided_tile->try_remove_plant();
-				}
-
-			}
+void PlantMode::use_tool( GroundTile* collided_tile )
+{
+	assert( collided_tile );
+	if( current_tool == default_hand ) {
+		// Harvesting plant or removing a dead one
+		if( collided_tile->plant_type
+			&& ( collided_tile->is_tile_harvestable() || collided_tile->is_plant_dead() ) ) {
+			Sound::play( *harvest_sound, 0.0f, 2.0f );
+			state.remove_plant( *collided_tile );
+		}
 
-		} else if( current_tool == watering_can ) {
-			collided_tile->moisture = 1.0f;
-		} else if( current_tool == fertilizer 
-				&& fertilization_cost <= num_coins 
-				&& !collided_tile->is_plant_dead()
-				&& collided_tile->plant_type && collided_tile->plant_health < 1.0f) {
-			change_num_coins( -fertilization_cost );
-			collided_tile->fertilization = fertilization_duration;
+	} else if( current_tool == watering_can ) {
+		collided_tile->moisture() = 1.0f;
+		collided_tile->wake();
+	} else if( current_tool == fertilizer ) {
+		if( state.fertilize_tile( *collided_tile ) ) {
 			Sound::play( *fertilize_sound, 0.0f, 1.0f );
-		} else if( current_tool == shovel ) {
-			// Remove any plant
-			if( collided_tile->plant_type ) {
-				Sound::play( *dig_sound, 0.0f, 2.0f );
-
-				if( collided_tile->is_tile_harvestable() )
-				{
-					PlantType const* plant = collided_tile->plant_type;
-					if( collided_tile->try_remove_plant() ) {
-						Sound::play( *harvest_sound, 0.0f, 2.0f );
-						assert( plant );
-						inventory.change_harvest_num( plant, 1 );
-					}
-				}
-				else
-				{
-					collided_tile->try_remove_plant();
-				}
-			}
-
-			if( collided_tile->can_be_cleared(grid) ) { // clearing the ground
-				int cost = collided_tile->tile_type->get_clear_cost();
-				if( cost <= num_coins && collided_tile->try_clear_tile() ) {
-					Sound::play( *dig_sound, 0.0f, 2.0f );
-					change_num_coins( -cost );
-				}
+		}
+	} else if( current_tool == shovel ) {
+		// Remove any plant
+		if( collided_tile->plant_type ) {
+			Sound::play( *dig_sound, 0.0f, 2.0f );
+			if( state.remove_plant( *collided_tile ) ) {
+				Sound::play( *harvest_sound, 0.0f, 2.0f );
 			}
+		}
 
-		} else if( current_tool == seed ) {
-			// Planting a plant
-			if(selectedPlant && inventory.get_seeds_num( selectedPlant ) > 0) {
-				if( collided_tile->try_add_plant( selectedPlant ) ) {
-					inventory.change_seeds_num( selectedPlant, -1 );
-					Sound::play( *plant_sound, 0.0f, 2.0f );
-				}
-			}
-			if( inventory.get_seeds_num( selectedPlant ) <= 0 ){
-				set_current_tool( default_hand );
-			}
+		// clearing the ground
+		if( state.clear_tile( *collided_tile ) ) {
+			Sound::play( *dig_sound, 0.0f, 2.0f );
 		}
 
+	} else if( current_tool == seed ) {
+		// Planting a plant
+		if( selectedPlant && state.plant_seed( *collided_tile, selectedPlant ) ) {
+			Sound::play( *plant_sound, 0.0f, 2.0f );
+		}
+		if( state.get_seeds_num( selectedPlant ) <= 0 ){
+			set_current_tool( default_hand );
+		}
 	}
 }
 
@@ -366,14 +331,14 @@ GroundTile* PlantMode::get_tile_under_mouse( int x, int y )
 	
 
 	float col_check_dist = 1000.0f;
-	glm::vec3 from_camera_start = camera->transform->position;
+	glm::vec3 from_camera_start = camera->transform->get_position();
 	glm::vec3 from_camera_dir = ray_wor;//camera->transform->rotation * glm::vec3( 0.0f, 0.0f, -1.0f );
 
 	// Check collision against each tile
 	GroundTile* collided_tile = nullptr;
-	for( int32_t x = 0; x < grid.size_x; ++x )
+	for( int32_t x = 0; x < grid->size_x; ++x )
 	{
-		for( int32_t y = 0; y < grid.size_y; ++y )
+		for( int32_t y = 0; y < grid->size_y; ++y )
 		{
 			// For now do a small sphere sweep against each triangle (TODO: optimize to line vs box collision if this is really bad)
 			float sphere_radius = 0.0001f;
@@ -386,7 +351,7 @@ GroundTile* PlantMode::get_tile_under_mouse( int x, int y )
 
 			float scale = plant_grid_tile_size.x / 2.0f;
 
-			glm::mat4x3 collider_to_world = grid.tiles[x][y].tile_drawable->transform->make_local_to_world();
+			glm::mat4x3 collider_to_world = grid_view.tiles[grid->get_index( x, y )].tile_drawable->transform->make_local_to_world();
 			glm::vec3 a = collider_to_world * glm::vec4( glm::vec3(1.0f, 1.0f, 0.2f) * scale, 1.0f );
 			glm::vec3 b = collider_to_world * glm::vec4( glm::vec3( -1.0f, 1.0f, 0.2f ) * scale, 1.0f );
 			glm::vec3 c = collider_to_world * glm::vec4( glm::vec3( 1.0f, -1.0f, 0.2f ) * scale, 1.0f );
@@ -403,7 +368,7 @@ GroundTile* PlantMode::get_tile_under_mouse( int x, int y )
 
 			if( did_collide )
 			{
-				collided_tile = &grid.tiles[x][y];
+				collided_tile = &grid->get_tile( x, y );
 			}
 		}
 	}
@@ -462,10 +427,38 @@ bool PlantMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size
 		case SDLK_c:
 			for( auto p : all_plants )
 			{
-				inventory.change_seeds_num( p, 1000 );
-				inventory.change_harvest_num( p, 1000 );
+				state.change_seeds_num( p, 1000 );
+				state.change_harvest_num( p, 1000 );
 			}
 			break;
+		case SDLK_t:
+			if( !paused ) world.fast_forward( fast_forward_time );
+			break;
+		case SDLK_i:
+			if( !paused ) show_island( ( world.visible + 1 ) % int( world.islands.size() ) );
+			break;
+		case SDLK_F5:
+		{
+			std::ofstream file( data_path( "quicksave.snapshot" ), std::ios::binary );
+			save_snapshot( &file );
+			if( !file ) std::cerr << "Failed to write quicksave." << std::endl;
+			break;
+		}
+		case SDLK_F9:
+		{
+			std::ifstream file( data_path( "quicksave.snapshot" ), std::ios::binary );
+			if( !file ) break;
+			try
+			{
+				load_snapshot( file );
+			}
+			catch( std::exception const& e )
+			{
+				// nothing got loaded, keep playing
+				std::cerr << "Failed to load quicksave: " << e.what() << std::endl;
+			}
+			break;
+		}
 		default:
 			if( UI.root ) UI.root->test_event_keyboard( evt.key.keysym.sym );
 			if( UI.root_pause ) UI.root_pause->test_event_keyboard( evt.key.keysym.sym );
@@ -571,25 +564,26 @@ void PlantMode::update(float elapsed)
 		float se = std::sin( camera_elevation );
 		float ca = std::cos( camera_azimuth );
 		float sa = std::sin( camera_azimuth );
-		camera->transform->position = real_camera_offset + camera_radius * glm::vec3( ce * ca, ce * sa, se );
-		camera->transform->rotation =
+		camera->transform->set_position( real_camera_offset + camera_radius * glm::vec3( ce * ca, ce * sa, se ) );
+		camera->transform->set_rotation(
 			glm::quat_cast( glm::transpose( glm::mat3( glm::lookAt(
-			camera->transform->position ,
+			camera->transform->get_position() ,
 			real_camera_offset,
 			glm::vec3( 0.0f, 0.0f, 1.0f )
-			) ) ) );
+			) ) ) ) );
 
 		//Sea positioning
-		sea->transform->position = camera->transform->position;
-		sea->transform->position.z = -0.15f;
+		glm::vec3 sea_position = camera->transform->get_position();
+		sea_position.z = -0.15f;
+		sea->transform->set_position( sea_position );
+
+		// the camera matrices below (view culling, mouse picking) are this frame's
+		scene.update_transforms();
 	}
 
 	if( !paused && !gameover )
 	{
 
-		// Update plant timer
-		plant_time += elapsed;
-
 		// update timer
 		{
 			timer += elapsed;
@@ -614,30 +608,11 @@ void PlantMode::update(float elapsed)
 
 		// update tiles
 		{
-			// initial update for grids themselves
-			for( int32_t x = 0; x < grid.size_x; ++x )
-			{
-				for( int32_t y = 0; y < grid.size_y; ++y )
-				{
-					grid.tiles[x][y].update( elapsed, camera->transform, grid );
-				}
-			}
-			// apply pending update from neighboring tiles
-			for( int32_t x = 0; x < plant_grid_x; ++x )
-			{
-				for( int32_t y = 0; y < plant_grid_y; ++y )
-				{
-					grid.tiles[x][y].apply_pending_update( elapsed );
-				}
-			}
-			// other visuals
-			for( int32_t x = 0; x < plant_grid_x; ++x )
-			{
-				for( int32_t y = 0; y < plant_grid_y; ++y )
-				{
-					grid.tiles[x][y].update_aura_visuals( elapsed, camera->transform );
-				}
-			}
+			// simulate the islands (spread across the worker threads)
+			world.update( elapsed );
+			float sim_alpha = world.get_visible().accumulator / sim_step;
+			// visuals touch the scene, so they stay on this thread
+			grid_view.update( elapsed, sim_alpha, camera->make_projection() * camera->transform->make_world_to_local() );
 		}
 
 		// Query for hovered tile
@@ -669,19 +644,19 @@ void PlantMode::update(float elapsed)
 
 				}
 				else if( current_tool == watering_can ) {
-					if( hovered_tile->tile_type->get_can_plant() && hovered_tile->moisture < 1.0f ) {
+					if( hovered_tile->tile_type->get_can_plant() && hovered_tile->moisture() < 1.0f ) {
 						action_description = "Water";
 					}
 
 				}
 				else if( current_tool == fertilizer ) {
 					if( !hovered_tile->is_plant_dead()
-							&& hovered_tile->plant_type && hovered_tile->plant_health < 1.0f) {
+							&& hovered_tile->plant_type && hovered_tile->plant_health() < 1.0f) {
 						action_description = "Spray -$" + std::to_string( fertilization_cost );
 					}
 				}
 				else if( current_tool == shovel ) {
-					if( hovered_tile->can_be_cleared( grid ) ) 
+					if( hovered_tile->can_be_cleared() ) 
 					{
 						action_description = "Dig -$" + std::to_string( hovered_tile->tile_type->get_clear_cost() );
 					}
@@ -709,11 +684,11 @@ void PlantMode::update(float elapsed)
 			{
 				if( hovered_tile && hovered_tile->tile_type != empty_tile )
 				{
-					selector->transform->position = hovered_tile->tile_drawable->transform->position + glm::vec3( 0.0f, 0.0f, -0.03f );
+					selector->transform->set_position( grid_view.tiles[hovered_tile->index].tile_drawable->transform->get_position() + glm::vec3( 0.0f, 0.0f, -0.03f ) );
 				}
 				else
 				{
-					selector->transform->position = glm::vec3( 0.0f, 0.0f, -1000.0f );
+					selector->transform->set_position( glm::vec3( 0.0f, 0.0f, -1000.0f ) );
 				}
 			}
 		}
@@ -727,7 +702,7 @@ void PlantMode::update(float elapsed)
 	{
 		if( UI.root_pause ) UI.root_pause->update( elapsed );
 		if( UI.root_title ) UI.root_title->update( elapsed );
-		selector->transform->position = glm::vec3( 0.0f, 0.0f, -1000.0f );
+		selector->transform->set_position( glm::vec3( 0.0f, 0.0f, -1000.0f ) );
 		set_current_tool( default_hand );
 	}
 
@@ -740,7 +715,7 @@ void PlantMode::update(float elapsed)
 			cursor.offset = glm::vec2( 0, 0 );
 			break;
 		case seed:
-			cursor.sprite = selectedPlant->get_seed_sprite();
+			cursor.sprite = get_plant_look( selectedPlant ).seed_sprite;
 			cursor.scale = 0.3f;
 			cursor.offset = glm::vec2( 0, 0 );
 			break;
@@ -795,16 +770,8 @@ void PlantMode::draw(glm::uvec2 const &drawable_size) {
 	glClear(GL_COLOR_BUFFER_BIT);
 	glm::mat4 world_to_clip = camera->make_projection() * camera->transform->make_world_to_local();
 	{ // actual drawing: create draw_aura instance and append the vertices
-		DrawAura draw_aura( world_to_clip );
-		for (int i=0; i<grid.size_x; i++) {
-			for (int j=0; j<grid.size_y; j++) {
-				if (grid.tiles[i][j].fire_aura) grid.tiles[i][j].fire_aura->draw( draw_aura );
-				if (grid.tiles[i][j].aqua_aura) grid.tiles[i][j].aqua_aura->draw( draw_aura );
-				if (grid.tiles[i][j].beacon_aura) grid.tiles[i][j].beacon_aura->draw( draw_aura );
-				if (grid.tiles[i][j].help_aura) grid.tiles[i][j].help_aura->draw( draw_aura );
-				if (grid.tiles[i][j].suck_aura) grid.tiles[i][j].suck_aura->draw( draw_aura );
-			}
-		}
+		DrawAura draw_aura( world_to_clip, camera->transform->get_rotation() );
+		grid_view.draw_auras( draw_aura );
 	}
 
 	//---- postprocessing pass ----
@@ -1113,230 +1080,73 @@ void PlantMode::on_unpaused()
 
 }
 
-int Inventory::get_seeds_num(const PlantType* plant ) 
-{
-	std::unordered_map<PlantType const*, int>::iterator it = plant_to_seeds.find( plant );
-	if( it != plant_to_seeds.end())
-	{
-		return it->second;
-	}
-	else 
-	{
-		if( plant ) plant_to_seeds.insert( std::make_pair( plant, 0 ) );
-		return 0;
-	}
-}
-
-void Inventory::change_seeds_num(const PlantType* plant, int seed_change )
+void PlantMode::on_seeds_changed( PlantType const* plant )
 {
-	assert( plant );
-	UIElem* btn = get_seed_item( plant );
-	int seed_num = 0;
-	std::unordered_map<PlantType const*, int>::iterator it = plant_to_seeds.find( plant );
-	if( it != plant_to_seeds.end() )
-	{
-		it->second += seed_change;
-		seed_num = it->second;
-	}
-	else
-	{
-		plant_to_seeds.insert( std::make_pair( plant, seed_change ) );
-		seed_num = seed_change;
-	}
+	UIElem* btn = inventory.get_seed_item( plant );
+	int seed_num = state.get_seeds_num( plant );
 	if( seed_num > 0)btn->set_text( std::to_string( seed_num ) );
 	else btn->set_text("");
 	assert( btn->get_parent() );
 	btn->get_parent()->layout_children();
 }
 
-int Inventory::get_harvest_num( const PlantType* plant ) {
-	std::unordered_map<PlantType const*, int>::iterator it = plant_to_harvest.find( plant );
-	if( it != plant_to_harvest.end() ) {
-		return it->second;
-	} else {
-		if( plant )plant_to_harvest.insert( std::make_pair( plant, 0 ) );
-		return 0;
-	}
-}
-
-void Inventory::change_harvest_num( const PlantType* plant, int harvest_change ) {
-	assert( plant );
-	int harvest_num = 0;
-	std::unordered_map<PlantType const*, int>::iterator it = plant_to_harvest.find( plant );
-	if( it != plant_to_harvest.end() ) 
-	{
-		it->second += harvest_change;
-		harvest_num = it->second;
-	} 
-	else
-	{
-		plant_to_harvest.insert( std::make_pair( plant, harvest_change ) );
-		harvest_num = harvest_change;
-	}
+void PlantMode::on_harvests_changed( PlantType const* plant )
+{
 	// update storage UI
-	UIElem* btn = get_harvest_item( plant );
+	UIElem* btn = inventory.get_harvest_item( plant );
+	int harvest_num = state.get_harvest_num( plant );
 	if( harvest_num > 0)btn->set_text( std::to_string( harvest_num ) );
 	else btn->set_text("");
 	assert( btn->get_parent() );
 	btn->get_parent()->layout_children();
-	// update orders. TODO: slightly too inefficient bc it's resetting everything including descriptions, etc.?
-	game->set_main_order(game->current_main_order_idx);
-	game->set_daily_order(game->current_daily_order_idx);
+	// update orders
+	update_requirement_text( plant );
 }
 
 UIElem* Inventory::get_seed_item( const PlantType* plant ) {
-	std::unordered_map<PlantType const*, UIElem*>::iterator it = plant_to_seed_item.find( plant );
-	assert( it != plant_to_seed_item.end() );
-	return it->second;
+	UIElem* item = seed_items[plant->get_id()];
+	assert( item );
+	return item;
 }
 
 UIElem* Inventory::get_harvest_item( const PlantType* plant ) {
-	std::unordered_map<PlantType const*, UIElem*>::iterator it = plant_to_harvest_item.find( plant );
-	assert( it != plant_to_harvest_item.end() );
-	return it->second;
+	UIElem* item = harvest_items[plant->get_id()];
+	assert( item );
+	return item;
 }
 
-void PlantMode::unlock_plant( const PlantType* plant )
+void PlantMode::on_plant_unlocked( const PlantType* plant )
 {
-	auto vit = std::find( unlocked_plants.begin(), unlocked_plants.end(), plant );
-	if( vit == unlocked_plants.end() )
+	// swaps the locked entry for the unlocked one, or back
+	UIElem* entry = plant_to_magicbook_entry[plant->get_id()];
+	assert( entry );
+	for( UIElem* c : entry->children )
 	{
-		auto it = plant_to_magicbook_entry.find( plant );
-		assert( it != plant_to_magicbook_entry.end() );
-		UIElem* entry = it->second;
-		for( UIElem* c : entry->children )
+		if( c->get_hidden() )
 		{
-			if( c->get_hidden() )
-			{
-				c->show();
-			}
-			else
-			{
-				c->hide();
-			}
+			c->show();
 		}
-		unlocked_plants.emplace_back( plant );
-	}
-	
-	
-}
-
-void PlantMode::lock_plant( const PlantType* plant )
-{
-	auto vit = std::find( unlocked_plants.begin(), unlocked_plants.end(), plant );
-	if( vit != unlocked_plants.end() )
-	{
-		auto it = plant_to_magicbook_entry.find( plant );
-		assert( it != plant_to_magicbook_entry.end() );
-		UIElem* entry = it->second;
-		for( UIElem* c : entry->children )
+		else
 		{
-			if( c->get_hidden() )
-			{
-				c->show();
-			}
-			else
-			{
-				c->hide();
-			}
+			c->hide();
 		}
-		unlocked_plants.erase( vit );
 	}
 }
 
-void PlantMode::change_num_coins(int change) {
-	num_coins += change;
-	UI.coins_text->set_text( std::to_string(num_coins) );
-
-	if( current_main_order && current_daily_order )
-	{
-		std::unordered_map<PlantType const*, int> main_plant_count = std::unordered_map<PlantType const*, int>();
-		std::unordered_map<PlantType const*, int> daily_plant_count = std::unordered_map<PlantType const*, int>();
-
-		// Add in how many required plants we need to fulfill orders
-		{
-			for (auto req : current_main_order->get_required_plants()) {
-				main_plant_count.insert(req);
-			}
-			for (auto req : current_daily_order->get_required_plants()) {
-				daily_plant_count.insert(req);
-			}
-		}
-
-		// Remove all plants harvested, as seeds or on tiles to get remaining to buy amount
-		{
-			auto it = main_plant_count.begin();
-			while( it != main_plant_count.end() )
-			{
-				it->second -= inventory.get_harvest_num( it->first ) + inventory.get_seeds_num( it->first );
-				it++;
-			}
-
-			it = daily_plant_count.begin();
-			while( it != daily_plant_count.end() )
-			{
-				it->second -= inventory.get_harvest_num( it->first ) + inventory.get_seeds_num( it->first );
-				it++;
-			}
-
-			for( int32_t x = 0; x < grid.size_x; ++x )
-			{
-				for( int32_t y = 0; y < grid.size_y; ++y )
-				{
-					GroundTile& tile = grid.tiles[x][y];
-					if( tile.plant_type && !tile.is_plant_dead() )
-					{
-						auto plant_it = main_plant_count.find( tile.plant_type );
-						if( plant_it != main_plant_count.end() )
-						{
-							plant_it->second--;
-							plant_it++;
-						}
-
-						plant_it = daily_plant_count.find( tile.plant_type );
-						if( plant_it != daily_plant_count.end() )
-						{
-							plant_it->second--;
-							plant_it++;
-						}
-					}
-				}
-			}
-		}
-
-		// Calculate how much money we still need to fulfill the order
-		{
-			int total_main_order_cost = 0;
-			auto it = main_plant_count.begin();
-			while( it != main_plant_count.end() && it->first )
-			{
-				if( it->second > 0 ) total_main_order_cost += ( it->first->get_cost() * it->second );
-				it++;
-			}
-
-			int total_daily_order_cost = 0;
-			it = daily_plant_count.begin();
-			while( it != daily_plant_count.end() && it->first )
-			{
-				if( it->second > 0 ) total_daily_order_cost += ( it->first->get_cost() * it->second );
-				it++;
-			}
-
-			int debt = total_main_order_cost;
-			if( total_daily_order_cost <= num_coins )
-			{
-				debt -= current_daily_order->get_bonus_cash();
-			}
+void PlantMode::on_coins_changed() {
+	UI.coins_text->set_text( std::to_string(state.num_coins) );
+}
 
-			if( debt > num_coins && UI.lose_screen->get_hidden() )
-			{
-				gameover = true;
-				UI.root->hide();
-				UI.root_gameover->show();
-				UI.win_screen->hide();
-				UI.lose_screen->show();
-			}
-		}
+void PlantMode::on_game_over() {
+	gameover = true;
+	UI.root->hide();
+	UI.root_gameover->show();
+	if( state.outcome == GameState::won ) {
+		UI.win_screen->show();
+		UI.lose_screen->hide();
+	} else {
+		UI.win_screen->hide();
+		UI.lose_screen->show();
 	}
 }
 
@@ -1345,46 +1155,58 @@ void PlantMode::set_current_tool(Tool tool) {
 	set_current_tool_tooltip( tool );
 }
 
-void PlantMode::set_main_order(int index) {
-	current_main_order = main_orders[index];
-	UI.main_order.description->set_text( current_main_order->get_description() );
-	UI.main_order.unlock_plant->set_text( "@ New Plants + $" + std::to_string(current_main_order->get_bonus_cash()));
-	UI.main_order.requirements->clear_children();
-	auto reqs = current_main_order->get_required_plants();
-	for (auto it=reqs.begin(); it!=reqs.end(); it++) {
-		UIElem* req = new UIElem(UI.main_order.requirements);
-		req->set_text(get_req_text(*it));
-		req->set_scale(0.36f);
-		req->set_tint(text_tint);
-		req->set_max_text_width(160.0f);
+void PlantMode::on_order_changed( int slot ) {
+	if( slot == GameState::main_order_slot ) {
+		OrderType const* current_main_order = state.current_main_order;
+		UI.main_order.description->set_text( current_main_order->get_description() );
+		UI.main_order.unlock_plant->set_text( "@ New Plants + $" + std::to_string(current_main_order->get_bonus_cash()));
+		UI.main_order.requirements->clear_children();
+		UI.main_order.requirement_labels.fill(nullptr);
+		PerPlant< int > const& reqs = current_main_order->get_required_plants();
+		for (int id : current_main_order->get_required_ids()) {
+			UIElem* req = new UIElem(UI.main_order.requirements);
+			req->set_text(get_req_text(all_plants[id], reqs[id]));
+			req->set_scale(0.36f);
+			req->set_tint(text_tint);
+			req->set_max_text_width(160.0f);
+			UI.main_order.requirement_labels[id] = req;
+		}
+		UI.main_order.requirements->layout_children();
+	} else {
+		OrderType const* current_daily_order = state.current_daily_order;
+		UI.daily_order.description->set_text( current_daily_order->get_description() );
+		UI.daily_order.reward->set_text( "For $" + std::to_string(current_daily_order->get_bonus_cash()) );
+		UI.daily_order.requirements->clear_children();
+		UI.daily_order.requirement_labels.fill(nullptr);
+		PerPlant< int > const& reqs = current_daily_order->get_required_plants();
+		for (int id : current_daily_order->get_required_ids()) {
+			UIElem* req = new UIElem(UI.daily_order.requirements);
+			req->set_text(get_req_text(all_plants[id], reqs[id]));
+			req->set_scale(0.36f);
+			req->set_tint(text_tint);
+			req->set_max_text_width(160.0f);
+			UI.daily_order.requirement_labels[id] = req;
+		}
+		UI.daily_order.requirements->layout_children();
 	}
-	UI.main_order.requirements->layout_children();
 }
 
-void PlantMode::set_daily_order(int index) {
-	if(index>daily_orders.size()){
-		current_daily_order = generate_random_daily_order();
-	}else{
-		current_daily_order = daily_orders[index];
-	}	
-	UI.daily_order.description->set_text( current_daily_order->get_description() );
-	UI.daily_order.reward->set_text( "For $" + std::to_string(current_daily_order->get_bonus_cash()) );
-	UI.daily_order.requirements->clear_children();
-	auto reqs = current_daily_order->get_required_plants();
-	for (auto it=reqs.begin(); it!=reqs.end(); it++) {
-		UIElem* req = new UIElem(UI.daily_order.requirements);
-		req->set_text(get_req_text(*it));
-		req->set_scale(0.36f);
-		req->set_tint(text_tint);
-		req->set_max_text_width(160.0f);
-	}
-	UI.daily_order.requirements->layout_children();
+std::string PlantMode::get_req_text(PlantType const* plant, int required_num) {
+	int num_harvest = state.get_harvest_num(plant);
+	return "- " + plant->get_name() + " " + 
+		std::to_string(num_harvest) + "/" + std::to_string(required_num);
 }
 
-std::string PlantMode::get_req_text(std::pair<PlantType const*, int> req) {
-	int num_harvest = inventory.get_harvest_num(req.first);
-	return "- " + req.first->get_name() + " " + 
-		std::to_string(num_harvest) + "/" + std::to_string(req.second);
+void PlantMode::update_requirement_text(PlantType const* plant) {
+	int id = plant->get_id();
+	if (UIElem* req = UI.main_order.requirement_labels[id]) {
+		req->set_text(get_req_text(plant, state.current_main_order->get_required_plants()[id]));
+		UI.main_order.requirements->layout_children();
+	}
+	if (UIElem* req = UI.daily_order.requirement_labels[id]) {
+		req->set_text(get_req_text(plant, state.current_daily_order->get_required_plants()[id]));
+		UI.daily_order.requirements->layout_children();
+	}
 }
 
 void PlantMode::set_current_tool_tooltip( Tool tool )
@@ -1407,7 +1229,7 @@ void PlantMode::set_current_tool_tooltip( Tool tool )
 		tool_description = "Remove grass/plants for planting new plants";
 		break;
 	case seed:
-		tool_name = selectedPlant->get_name() + " x" + std::to_string( inventory.get_seeds_num( selectedPlant ) ) + " :";
+		tool_name = selectedPlant->get_name() + " x" + std::to_string( state.get_seeds_num( selectedPlant ) ) + " :";
 		tool_description = selectedPlant->get_description();
 		break;
 	}
@@ -2,11 +2,14 @@
 
 #include "Mode.hpp"
 
+#include "Archipelago.hpp"
 #include "BoneAnimation.hpp"
+#include "GameState.hpp"
 #include "GL.hpp"
 #include "Scene.hpp"
 #include "Order.hpp"
 #include "UIElem.hpp"
+#include "WorkerPool.hpp"
 
 #include <SDL.h>
 #include <glm/glm.hpp>
@@ -17,66 +20,69 @@
 #include <iostream>
 #include "Plant.hpp"
 
-struct PlantMode;
-
+// the storage items showing the seed and harvest counts (the counts are in GameState)
 struct Inventory
 { 
-	Inventory(PlantMode* _game) : game(_game) { assert(game); }
-
-	int get_seeds_num( const PlantType* plant );
-	void change_seeds_num(const PlantType* plant, int seed_change );
-	int get_harvest_num( const PlantType* plant );
-	void change_harvest_num(const PlantType* plant, int harvest_change );
-
 	UIElem* get_seed_item( const PlantType* plant );
-	void set_seed_item( const PlantType* plant, UIElem* item ) { plant_to_seed_item.insert( std::make_pair( plant, item ) ); }
+	void set_seed_item( const PlantType* plant, UIElem* item ) { seed_items[plant->get_id()] = item; }
 	UIElem* get_harvest_item( const PlantType* plant );
-	void set_harvest_item( const PlantType* plant, UIElem* item ) { plant_to_harvest_item.insert( std::make_pair( plant, item ) ); }
+	void set_harvest_item( const PlantType* plant, UIElem* item ) { harvest_items[plant->get_id()] = item; }
 
 	static bool comp_fn(std::pair<PlantType const*, int> p1, std::pair<PlantType const*, int> p2) {
 		return p1.second > p2.second;
 	} // use this to sort entries in descending order
 
-	//getters
-	std::unordered_map<PlantType const*, int> get_plant_to_seeds() { return plant_to_seeds; }
-	std::unordered_map<PlantType const*, int> get_plant_to_harvest() { return plant_to_harvest; }
 private:
-	std::unordered_map<PlantType const*, int> plant_to_seeds;
-	std::unordered_map<PlantType const*, int> plant_to_harvest;
-	std::unordered_map<PlantType const*, UIElem*> plant_to_seed_item;
-	std::unordered_map<PlantType const*, UIElem*> plant_to_harvest_item;
-
-	PlantMode* game = nullptr;
+	PerPlant< UIElem* > seed_items = {};
+	PerPlant< UIElem* > harvest_items = {};
 };
 
 // The 'PlantMode':
-struct PlantMode : public Mode 
+struct PlantMode : public Mode, public GameObserver
 {
-	PlantMode();
+	PlantMode( int island_count = 1 );
 	virtual ~PlantMode();
 	void reset_game();
+	// builds the starting island, inventory and orders (reset_game restores a snapshot of it afterwards)
+	void setup_new_game();
+
+	// binary snapshot of the whole game state (see PlantMode+Snapshot.cpp)
+	void save_snapshot( std::ostream* to );
+	void load_snapshot( std::istream& from );
+	std::string reset_snapshot;
 
 	float timer = 0.0f;
 	bool title = true;
 	bool gameover = false;
 
+	// coins, seeds, harvests, unlocked plants and orders, and the rules for them; the UI follows
+	// them through the GameObserver calls below
+	GameState state;
+	virtual void on_coins_changed() override;
+	virtual void on_seeds_changed( PlantType const* plant ) override;
+	virtual void on_harvests_changed( PlantType const* plant ) override;
+	virtual void on_plant_unlocked( PlantType const* plant ) override;
+	virtual void on_order_changed( int slot ) override;
+	virtual void on_order_completed( int slot ) override;
+	virtual void on_game_over() override;
+
 	//orders:
-	int current_daily_order_idx = 0;
-	OrderType const* current_daily_order = nullptr;
 	bool cancel_order_state = false;
 	float cancel_order_freeze_time = 10;
-	int current_main_order_idx = 0;
-	OrderType const* current_main_order = nullptr;
-	void set_main_order(int index);
-	void set_daily_order(int index);
-	std::string get_req_text(std::pair<PlantType const*, int> req);
+	std::string get_req_text(PlantType const* plant, int required_num);
+	// refresh the requirement labels showing this plant
+	void update_requirement_text(PlantType const* plant);
 	
 	// init harvest_plant_map
 	// Harvest Plant Map
 	std::map< PlantType const*, int > harvest_plant_map;
     
 	void on_click( int x, int y );
+	// what a click with the current tool does to a tile (on_click, after the UI had its chance)
+	void use_tool( GroundTile* tile );
 	GroundTile* get_tile_under_mouse( int x, int y);
+	// magicbook buy button, false if there isn't enough money
+	bool buy_seed( PlantType const* plant );
 	virtual bool handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) override;
 	virtual void update(float elapsed) override;
 	virtual void draw(glm::uvec2 const &drawable_size) override;
@@ -99,19 +105,33 @@ struct PlantMode : public Mode
 	std::vector<Tool> scroll_tool_order;
 
 	// Magicbook unlocking
-	void unlock_plant(const PlantType *plant);
-	void lock_plant( const PlantType* plant );
-	std::unordered_map<PlantType const*, UIElem*> plant_to_magicbook_entry;
-	std::vector<PlantType const*> unlocked_plants;
+	PerPlant< UIElem* > plant_to_magicbook_entry = {};
 
 	float scroll_delay = 0.0f;
 
 	const float inactivity_reset_time = 90;
 	float current_reset_time = 0;
 	
-	Inventory inventory = Inventory(this);
-	int num_coins = 30;
-	void change_num_coins(int change);
+	// threads for the tile simulation
+	WorkerPool workers;
+	// every island keeps its own clock and runs as its own job (see Archipelago.hpp); orders count
+	// the plants on all of them, but only the visible one is drawn and played on
+	Archipelago world;
+	TileGrid* grid = nullptr; // the visible island
+	void show_island( int index );
+	// drawables, auras and sounds of the visible island's tiles
+	TileGridView grid_view;
+
+	// the tiles are simulated in fixed steps, leftover time blends the plant visuals between steps
+	static constexpr float sim_step = 1.0f / 60.0f;
+	// more time than this piling up (a stall, a minimized window) gets fast forwarded instead of stepped
+	static constexpr float max_sim_backlog = 1.0f;
+	// how far beacon flowers pass their aura on (see TileGrid::beacon_aura_radius)
+	static constexpr int beacon_aura_radius = 1;
+	// skipped by the fast forward key
+	const float fast_forward_time = 600.0f;
+
+	Inventory inventory;
 
 	glm::vec3 forward_camera_dir = glm::vec3();
 	glm::vec3 forward_dir = glm::vec3();
@@ -156,11 +176,13 @@ struct PlantMode : public Mode
 		struct {
 			UIElem* description;
 			UIElem* requirements;
+			PerPlant< UIElem* > requirement_labels = {};
 			UIElem* unlock_plant;
 		} main_order;
 		struct {
 			UIElem* description;
 			UIElem* requirements;
+			PerPlant< UIElem* > requirement_labels = {};
 			UIElem* reward;
 		} daily_order;
 
@@ -0,0 +1,25 @@
+#include "Random.hpp"
+
+uint32_t random_seed = 1;
+
+RandomStream aura_random;
+RandomStream shake_random;
+RandomStream order_random;
+
+uint32_t mix_seed( uint32_t seed, uint32_t stream ) {
+	//murmur3 finalizer over seed and stream:
+	uint32_t h = seed ^ ( stream * 0x9E3779B9u );
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+	return h ? h : 1;
+}
+
+void seed_random_streams( uint32_t seed ) {
+	random_seed = seed;
+	aura_random.set_seed( mix_seed( seed, aura_stream ) );
+	shake_random.set_seed( mix_seed( seed, shake_stream ) );
+	order_random.set_seed( mix_seed( seed, order_stream ) );
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+//Seeded random numbers for the simulation.
+//Each subsystem draws from its own stream, so a run is reproducible from a single seed and
+// drawing more numbers in one subsystem doesn't shift the numbers seen by another.
+
+//small deterministic generator, state must not be zero:
+inline uint32_t xorshift32( uint32_t &state ) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+//derive a (non-zero) stream seed from the run seed and a stream id:
+uint32_t mix_seed( uint32_t seed, uint32_t stream );
+
+struct RandomStream {
+	RandomStream( uint32_t seed = 1 ) { set_seed( seed ); }
+	void set_seed( uint32_t seed ) { state = ( seed ? seed : 1 ); }
+
+	uint32_t next() { return xorshift32( state ); }
+	//in [0,1):
+	float next_float() { return float( next() >> 8 ) * ( 1.0f / 16777216.0f ); }
+	//in [0,count):
+	uint32_t next_below( uint32_t count ) { return next() % count; }
+
+	uint32_t state = 1;
+};
+
+//the seed used by the last seed_random_streams() call:
+extern uint32_t random_seed;
+
+//streams for code that isn't tied to a TileGrid:
+extern RandomStream aura_random; //aura dot placement
+extern RandomStream shake_random; //plant shake jitter
+extern RandomStream order_random; //generate_random_daily_order
+
+void seed_random_streams( uint32_t seed );
+
+//stream ids for mix_seed:
+enum RandomStreamId : uint32_t {
+	aura_stream = 1,
+	shake_stream,
+	order_stream,
+	teleport_stream,
+	autoplay_stream,
+	tile_stream_base = 0x100, //+ tile index
+	island_stream_base = 0x80000000u, //+ island index (Archipelago)
+};
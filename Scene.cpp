@@ -5,7 +5,10 @@
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <cstddef>
 #include <fstream>
+#include <tuple>
 
 //-------------------------
 
@@ -45,18 +48,32 @@ glm::mat4 Scene::Transform::make_parent_to_local() const {
 	);
 }
 
-glm::mat4 Scene::Transform::make_local_to_world() const {
-	if (!parent) {
-		return make_local_to_parent();
+void Scene::update_transform(Transform const &transform, uint32_t pass) {
+	if (transform.visited_pass == pass) return;
+	transform.visited_pass = pass;
+
+	bool parent_changed = false;
+	if (transform.parent) {
+		update_transform(*transform.parent, pass);
+		parent_changed = (transform.parent->changed_pass == pass);
+	}
+	if (!transform.dirty && !parent_changed) return;
+
+	if (!transform.parent) {
+		transform.local_to_world = transform.make_local_to_parent();
+		transform.world_to_local = transform.make_parent_to_local();
 	} else {
-		return parent->make_local_to_world() * make_local_to_parent();
+		transform.local_to_world = transform.parent->local_to_world * transform.make_local_to_parent();
+		transform.world_to_local = transform.make_parent_to_local() * transform.parent->world_to_local;
 	}
+	transform.dirty = false;
+	transform.changed_pass = pass;
 }
-glm::mat4 Scene::Transform::make_world_to_local() const {
-	if (!parent) {
-		return make_parent_to_local();
-	} else {
-		return make_parent_to_local() * parent->make_world_to_local();
+
+void Scene::update_transforms() const {
+	if (++transform_pass == 0) ++transform_pass; //(0 is what new transforms start at)
+	for (auto const &transform : transforms) {
+		update_transform(transform, transform_pass);
 	}
 }
 
@@ -71,44 +88,219 @@ glm::mat4 Scene::Camera::make_projection() const {
 
 void Scene::draw(Camera const &camera) const {
 	assert(camera.transform);
+	update_transforms(); //(in case the camera is one of ours and moved since the last pass)
 	glm::mat4 world_to_clip = camera.make_projection() * camera.transform->make_world_to_local();
 	glm::mat4x3 world_to_light = glm::mat4x3(1.0f);
 	draw(world_to_clip, world_to_light);
 }
 
+GLuint Scene::get_instance_buffer() {
+	static GLuint buffer = 0;
+	if (buffer == 0) glGenBuffers(1, &buffer);
+	return buffer;
+}
+
+std::map< std::string, Attrib const * > const &Scene::get_instance_attribs() {
+	static std::map< std::string, Attrib const * > attribs;
+	static Attrib columns[4];
+	static Attrib properties;
+	if (attribs.empty()) {
+		GLuint buffer = get_instance_buffer();
+		for (uint32_t c = 0; c < 4; ++c) {
+			columns[c] = Attrib(buffer, 3, GL_FLOAT, Attrib::AsFloat, sizeof(Instance), offsetof(Instance, object_to_world) + c * sizeof(glm::vec3));
+			columns[c].divisor = 1;
+			attribs["ObjectToWorld" + std::to_string(c)] = &columns[c];
+		}
+		properties = Attrib(buffer, 3, GL_FLOAT, Attrib::AsFloat, sizeof(Instance), offsetof(Instance, properties));
+		properties.divisor = 1;
+		attribs["Properties"] = &properties;
+	}
+	return attribs;
+}
+
+//true if the box (in object space) is certainly outside one of the frustum planes:
+static bool outside_frustum(glm::vec4 const (&planes)[6], glm::mat4 const &object_to_world, glm::vec3 const &min, glm::vec3 const &max) {
+	//the box in world space, as center and (axis-aligned) half extents:
+	glm::vec3 center = glm::vec3(object_to_world * glm::vec4(0.5f * (min + max), 1.0f));
+	glm::vec3 half = 0.5f * (max - min);
+	glm::vec3 extent =
+		glm::abs(glm::vec3(object_to_world[0])) * half.x
+		+ glm::abs(glm::vec3(object_to_world[1])) * half.y
+		+ glm::abs(glm::vec3(object_to_world[2])) * half.z;
+	for (glm::vec4 const &plane : planes) {
+		glm::vec3 normal = glm::vec3(plane);
+		if (glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), extent) < 0.0f) return true;
+	}
+	return false;
+}
+
 void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light) const {
+	typedef Drawable::Pipeline Pipeline;
+	draw_stats = DrawStats();
+
+	//each transform's matrices get computed at most once, however many drawables read them:
+	update_transforms();
+
+	//frustum planes in world space (inside where dot(plane, (p,1)) >= 0), from the rows of world_to_clip:
+	glm::vec4 planes[6];
+	{
+		glm::mat4 rows = glm::transpose(world_to_clip);
+		for (int axis = 0; axis < 3; ++axis) {
+			planes[2 * axis + 0] = rows[3] + rows[axis];
+			planes[2 * axis + 1] = rows[3] - rows[axis];
+		}
+	}
+
+	//instanced drawables get collected into batches, each of which is drawn with one call:
+	auto batch_key = [](Pipeline const &pipeline) {
+		return std::make_tuple(pipeline.instanced.program, pipeline.instanced.vao, pipeline.type, pipeline.start, pipeline.count,
+			pipeline.textures[0].texture, pipeline.textures[1].texture, pipeline.textures[2].texture, pipeline.textures[3].texture);
+	};
+	struct Batch {
+		Pipeline const *pipeline; //first drawable's pipeline, stands in for the rest
+		std::vector< Instance > instances;
+	};
+	std::map< decltype(batch_key(Pipeline())), Batch > batches;
+
+	//everything else (and the batches) goes into a render queue:
+	struct QueueItem {
+		Pipeline const *pipeline;
+		GLuint program;
+		GLuint vao;
+		float depth; //clip-space w of the object's origin
+		glm::mat4 object_to_world; //(unused for batches)
+		Batch const *batch; //null for single drawables
+	};
+	std::vector< QueueItem > queue;
+	queue.reserve(drawables.size());
 
-	//Iterate through all drawables, sending each one to OpenGL:
 	for (auto const &drawable : drawables) {
 		//Reference to drawable's pipeline for convenience:
 		Scene::Drawable::Pipeline const &pipeline = drawable.pipeline;
 
 		//skip any drawables without a shader program set:
-		if (pipeline.program == 0) continue;
+		if (pipeline.program == 0 && pipeline.instanced.program == 0) continue;
 		//skip any drawables that don't contain any vertices:
 		if (pipeline.count == 0) continue;
 
+		//the object-to-world matrix is used in all the uniforms below:
+		assert(drawable.transform); //drawables *must* have a transform
+		glm::mat4 object_to_world = drawable.transform->make_local_to_world();
+
+		//skip drawables that can't end up on screen:
+		if (drawable.bounds_min.x <= drawable.bounds_max.x
+		 && outside_frustum(planes, object_to_world, drawable.bounds_min, drawable.bounds_max)) {
+			++draw_stats.culled;
+			continue;
+		}
+
+		if (pipeline.instanced.program != 0) {
+			Batch &batch = batches[batch_key(pipeline)];
+			if (batch.instances.empty()) batch.pipeline = &pipeline;
+			batch.instances.push_back(Instance{ glm::mat4x3(object_to_world), pipeline.properties });
+			continue;
+		}
+
+		float depth = (world_to_clip * object_to_world[3]).w;
+		queue.push_back(QueueItem{ &pipeline, pipeline.program, pipeline.vao, depth, object_to_world, nullptr });
+	}
+	for (auto const &key_batch : batches) {
+		Batch const &batch = key_batch.second;
+		Pipeline const &pipeline = *batch.pipeline;
+		queue.push_back(QueueItem{ &pipeline, pipeline.instanced.program, pipeline.instanced.vao, 0.0f, glm::mat4(1.0f), &batch });
+	}
+
+	//sort so that items sharing program, vao and textures are drawn back to back, nearer ones first:
+	auto sort_key = [](QueueItem const &item) {
+		Pipeline const &pipeline = *item.pipeline;
+		return std::make_tuple(item.program, item.vao,
+			pipeline.textures[0].texture, pipeline.textures[1].texture, pipeline.textures[2].texture, pipeline.textures[3].texture,
+			item.depth);
+	};
+	std::stable_sort(queue.begin(), queue.end(), [&sort_key](QueueItem const &a, QueueItem const &b) {
+		return sort_key(a) < sort_key(b);
+	});
+
+	//the state currently bound, so binds that wouldn't change anything can be skipped:
+	GLuint bound_program = 0;
+	GLuint bound_vao = 0;
+	Pipeline::TextureInfo bound_textures[Pipeline::TextureCount];
+	GLuint active_texture = 0;
+	//(drawing every item on its own binds and then un-binds each of its textures)
+	uint32_t unsorted_texture_binds = 0;
+
+	for (QueueItem const &item : queue) {
+		Pipeline const &pipeline = *item.pipeline;
 
 		//Set shader program:
-		glUseProgram(pipeline.program);
+		if (item.program != bound_program) {
+			glUseProgram(item.program);
+			bound_program = item.program;
+			++draw_stats.program_binds;
+		} else {
+			++draw_stats.program_binds_skipped;
+		}
 
 		//Set attribute sources:
-		glBindVertexArray(pipeline.vao);
+		if (item.vao != bound_vao) {
+			glBindVertexArray(item.vao);
+			bound_vao = item.vao;
+			++draw_stats.vao_binds;
+		} else {
+			++draw_stats.vao_binds_skipped;
+		}
 
-		//Configure program uniforms:
+		//set up textures (units this item doesn't use get emptied, as they would have been un-bound):
+		for (uint32_t i = 0; i < Pipeline::TextureCount; ++i) {
+			Pipeline::TextureInfo const &want = pipeline.textures[i];
+			Pipeline::TextureInfo &have = bound_textures[i];
+			if (want.texture != 0) unsorted_texture_binds += 2;
+			if (want.texture == have.texture && (want.texture == 0 || want.target == have.target)) continue;
+			if (active_texture != i) {
+				glActiveTexture(GL_TEXTURE0 + i);
+				active_texture = i;
+			}
+			if (have.texture != 0 && (want.texture == 0 || want.target != have.target)) {
+				glBindTexture(have.target, 0);
+				++draw_stats.texture_binds;
+			}
+			if (want.texture != 0) {
+				glBindTexture(want.target, want.texture);
+				++draw_stats.texture_binds;
+			}
+			have = want;
+		}
 
-		//the object-to-world matrix is used in all three of these uniforms:
-		assert(drawable.transform); //drawables *must* have a transform
-		glm::mat4 object_to_world = drawable.transform->make_local_to_world();
+		if (item.batch) {
+			//instanced batch: stream its instances through the (orphaned) instance buffer:
+			std::vector< Instance > const &instances = item.batch->instances;
+			glBindBuffer(GL_ARRAY_BUFFER, get_instance_buffer());
+			glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(Instance), instances.data(), GL_STREAM_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			if (pipeline.instanced.WORLD_TO_CLIP_mat4 != -1U) {
+				glUniformMatrix4fv(pipeline.instanced.WORLD_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(world_to_clip));
+			}
+			if (pipeline.instanced.WORLD_TO_LIGHT_mat4x3 != -1U) {
+				glUniformMatrix4x3fv(pipeline.instanced.WORLD_TO_LIGHT_mat4x3, 1, GL_FALSE, glm::value_ptr(world_to_light));
+			}
+
+			glDrawArraysInstanced(pipeline.type, pipeline.start, pipeline.count, GLsizei(instances.size()));
+			++draw_stats.draw_calls;
+			draw_stats.drawables += uint32_t(instances.size());
+			continue;
+		}
+
+		//Configure program uniforms:
 
 		//OBJECT_TO_CLIP takes vertices from object space to clip space:
 		if (pipeline.OBJECT_TO_CLIP_mat4 != -1U) {
-			glm::mat4 object_to_clip = world_to_clip * object_to_world;
+			glm::mat4 object_to_clip = world_to_clip * item.object_to_world;
 			glUniformMatrix4fv(pipeline.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
 		}
 
 		//the object-to-light matrix is used in the next two uniforms:
-		glm::mat4x3 object_to_light = world_to_light * object_to_world;
+		glm::mat4x3 object_to_light = world_to_light * item.object_to_world;
 
 		//OBJECT_TO_CLIP takes vertices from object space to light space:
 		if (pipeline.OBJECT_TO_LIGHT_mat4x3 != -1U) {
@@ -124,27 +316,22 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 		//set any requested custom uniforms:
 		if (pipeline.set_uniforms) pipeline.set_uniforms();
 
-		//set up textures:
-		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
-			if (pipeline.textures[i].texture != 0) {
-				glActiveTexture(GL_TEXTURE0 + i);
-				glBindTexture(pipeline.textures[i].target, pipeline.textures[i].texture);
-			}
-		}
-
 		//draw the object:
 		glDrawArrays(pipeline.type, pipeline.start, pipeline.count);
+		++draw_stats.draw_calls;
+		++draw_stats.drawables;
+	}
 
-		//un-bind textures:
-		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
-			if (pipeline.textures[i].texture != 0) {
-				glActiveTexture(GL_TEXTURE0 + i);
-				glBindTexture(pipeline.textures[i].target, 0);
-			}
+	//un-bind textures:
+	for (uint32_t i = 0; i < Pipeline::TextureCount; ++i) {
+		if (bound_textures[i].texture != 0) {
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(bound_textures[i].target, 0);
+			++draw_stats.texture_binds;
 		}
-		glActiveTexture(GL_TEXTURE0);
-
 	}
+	glActiveTexture(GL_TEXTURE0);
+	draw_stats.texture_binds_skipped = unsorted_texture_binds > draw_stats.texture_binds ? unsorted_texture_binds - draw_stats.texture_binds : 0;
 
 	glUseProgram(0);
 	glBindVertexArray(0);
@@ -221,7 +408,7 @@ void Scene::load(std::string const &filename,
 			if (h.parent >= hierarchy_transforms.size()) {
 				throw std::runtime_error("scene file '" + filename + "' did not contain transforms in topological-sort order.");
 			}
-			t->parent = hierarchy_transforms[h.parent];
+			t->set_parent(hierarchy_transforms[h.parent]);
 		}
 
 		if (h.name_begin <= h.name_end && h.name_end <= names.size()) {
@@ -230,9 +417,9 @@ void Scene::load(std::string const &filename,
 				throw std::runtime_error("scene file '" + filename + "' contains hierarchy entry with invalid name indices");
 		}
 
-		t->position = h.position;
-		t->rotation = h.rotation;
-		t->scale = h.scale;
+		t->set_position(h.position);
+		t->set_rotation(h.rotation);
+		t->set_scale(h.scale);
 
 		hierarchy_transforms.emplace_back(t);
 	}
@@ -291,7 +478,8 @@ void Scene::load(std::string const &filename,
 		light->spot_fov = l.fov / 180.0f * 3.1415926f; //FOV is stored in degrees; convert to radians.
 	}
 
-
+	//so the loaded transforms can be read right away:
+	update_transforms();
 }
 
 //-------------------------
@@ -309,50 +497,55 @@ Scene &Scene::operator=(Scene const &other) {
 	return *this;
 }
 
-void Scene::set(Scene const &other, std::unordered_map< Transform const *, Transform * > *transform_map_) {
+void Scene::set(Scene const &other, std::vector< Transform * > *transform_map_) {
 
-	std::unordered_map< Transform const *, Transform * > t2t_temp;
-	std::unordered_map< Transform const *, Transform * > &transform_to_transform = *(transform_map_ ? transform_map_ : &t2t_temp);
+	std::vector< Transform * > t2t_temp;
+	std::vector< Transform * > &transform_to_transform = *(transform_map_ ? transform_map_ : &t2t_temp);
 
-	transform_to_transform.clear();
-
-	//null transform maps to itself:
-	transform_to_transform.insert(std::make_pair(nullptr, nullptr));
+	//slot index in other -> transform here (the slot maps make this a plain array instead of a hash map):
+	transform_to_transform.assign(other.transforms.slot_count(), nullptr);
+	auto remap = [&](Transform const *t) -> Transform * {
+		return t ? transform_to_transform[other.transforms.index_of(t)] : nullptr;
+	};
 
 	//Copy transforms and store mapping:
 	for (auto const &t : other.transforms) {
 		transforms.emplace_back();
 		transforms.back().name = t.name;
-		transforms.back().position = t.position;
-		transforms.back().rotation = t.rotation;
-		transforms.back().scale = t.scale;
-		transforms.back().parent = t.parent; //will update later
+		transforms.back().set_position(t.get_position());
+		transforms.back().set_rotation(t.get_rotation());
+		transforms.back().set_scale(t.get_scale());
 
 		//store mapping between transforms old and new:
-		auto ret = transform_to_transform.insert(std::make_pair(&t, &transforms.back()));
-		assert(ret.second);
+		transform_to_transform[other.transforms.index_of(&t)] = &transforms.back();
 	}
 
 	//update transform parents:
-	for (auto &t : transforms) {
-		t.parent = transform_to_transform.at(t.parent);
+	for (auto const &t : other.transforms) {
+		remap(&t)->set_parent(remap(t.get_parent()));
 	}
 
 	//copy other's drawables, updating transform pointers:
-	drawables = other.drawables;
-	for (auto &d : drawables) {
-		d.transform = transform_to_transform.at(d.transform);
+	drawables.clear();
+	for (auto const &d : other.drawables) {
+		drawables.emplace_back(d);
+		drawables.back().transform = remap(d.transform);
 	}
 
 	//copy other's cameras, updating transform pointers:
-	cameras = other.cameras;
-	for (auto &c : cameras) {
-		c.transform = transform_to_transform.at(c.transform);
+	cameras.clear();
+	for (auto const &c : other.cameras) {
+		cameras.emplace_back(c);
+		cameras.back().transform = remap(c.transform);
 	}
 
 	//copy other's lights, updating transform pointers:
-	lights = other.lights;
-	for (auto &l : lights) {
-		l.transform = transform_to_transform.at(l.transform);
+	lights.clear();
+	for (auto const &l : other.lights) {
+		lights.emplace_back(l);
+		lights.back().transform = remap(l.transform);
 	}
+
+	//so the copied transforms can be read right away:
+	update_transforms();
 }
@@ -13,16 +13,18 @@
  */
 
 #include "GL.hpp"
+#include "make_vao_for_program.hpp"
+#include "SlotMap.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
-#include <list>
+#include <limits>
+#include <map>
 #include <memory>
 #include <functional>
 #include <string>
 #include <vector>
-#include <unordered_map>
 
 struct Scene {
 	struct Transform {
@@ -30,25 +32,44 @@ struct Scene {
 		std::string name;
 
 		//The core function of a transform is to store a transformation in the world:
-		glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f);
-		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f); //n.b. wxyz init order
-		glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f);
+		// (changes go through the setters, which mark the cached matrices below as out of date)
+		glm::vec3 const &get_position() const { return position; }
+		glm::quat const &get_rotation() const { return rotation; }
+		glm::vec3 const &get_scale() const { return scale; }
+		void set_position(glm::vec3 const &position_) { position = position_; dirty = true; }
+		void set_rotation(glm::quat const &rotation_) { rotation = rotation_; dirty = true; }
+		void set_scale(glm::vec3 const &scale_) { scale = scale_; dirty = true; }
 
 		//The transform above may be relative to some parent transform:
-		Transform *parent = nullptr;
+		Transform *get_parent() const { return parent; }
+		void set_parent(Transform *parent_) { parent = parent_; dirty = true; }
 
 		//It is often convenient to construct matrices representing this transformation:
 		// ..relative to its parent:
 		glm::mat4 make_local_to_parent() const;
 		glm::mat4 make_parent_to_local() const;
-		// ..relative to the world:
-		glm::mat4 make_local_to_world() const;
-		glm::mat4 make_world_to_local() const;
+		// ..relative to the world, as of the last Scene::update_transforms (which Scene::draw starts with):
+		glm::mat4 make_local_to_world() const { return local_to_world; }
+		glm::mat4 make_world_to_local() const { return world_to_local; }
 
 		//since hierarchy is tracked through pointers, copy-constructing a transform  is not advised:
 		Transform(Transform const &) = delete;
 		//if we delete some constructors, we need to let the compiler know that the default constructor is still okay:
 		Transform() = default;
+
+	private:
+		friend struct Scene;
+		glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f);
+		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f); //n.b. wxyz init order
+		glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f);
+		Transform *parent = nullptr;
+
+		//cache, kept by Scene::update_transforms:
+		mutable bool dirty = true; //set by the setters; children recompute along with their parent without it
+		mutable uint32_t visited_pass = 0; //last pass that brought this transform up to date
+		mutable uint32_t changed_pass = 0; //last pass that recomputed its matrices
+		mutable glm::mat4 local_to_world = glm::mat4(1.0f);
+		mutable glm::mat4 world_to_local = glm::mat4(1.0f);
 	};
 
 	struct Drawable {
@@ -56,6 +77,11 @@ struct Scene {
 		Drawable(Transform *transform_) : transform(transform_) { assert(transform); }
 		Transform * transform;
 
+		//object-space bounding box of what the pipeline draws (usually the Mesh's min/max), for culling:
+		// drawables that keep the default (empty) box are never culled
+		glm::vec3 bounds_min = glm::vec3( std::numeric_limits< float >::infinity());
+		glm::vec3 bounds_max = glm::vec3(-std::numeric_limits< float >::infinity());
+
 		//Contains all the data needed to run the OpenGL pipeline:
 		struct Pipeline {
 			GLuint program = 0; //shader program; passed to glUseProgram
@@ -74,6 +100,17 @@ struct Scene {
 
 			std::function< void() > set_uniforms; //(optional) function to set any other useful uniforms
 
+			//(optional) instanced variant of this pipeline:
+			// drawables whose instanced variants share program, vao, primitive range and textures are drawn
+			// together with one glDrawArraysInstanced, with 'properties' in place of set_uniforms (see Scene::Instance)
+			struct Instanced {
+				GLuint program = 0; //takes ObjectToWorld0-3 and Properties per instance
+				GLuint vao = 0; //mesh attributes plus the instance buffer (see MeshBuffer::make_instanced_vao_for_program)
+				GLuint WORLD_TO_CLIP_mat4 = -1U;
+				GLuint WORLD_TO_LIGHT_mat4x3 = -1U;
+			} instanced;
+			glm::vec3 properties = glm::vec3(1.0f, 0.0f, 0.0f);
+
 			//texture objects to bind for the first TextureCount textures:
 			enum : uint32_t { TextureCount = 4 };
 			struct TextureInfo {
@@ -117,11 +154,31 @@ struct Scene {
 		float spot_fov = glm::radians(45.0f);
 	};
 
+	//Per-instance data of instanced drawing, as streamed to the instance buffer:
+	struct Instance {
+		glm::mat4x3 object_to_world;
+		glm::vec3 properties;
+	};
+	//the buffer instanced drawing streams Instances through (created on first use):
+	static GLuint get_instance_buffer();
+	//attributes for instanced vaos to read Instances with ("ObjectToWorld0"-"ObjectToWorld3" and "Properties"):
+	static std::map< std::string, Attrib const * > const &get_instance_attribs();
+
+	//bring every transform's cached matrices up to date in one pass, parents before their children
+	// (draw starts with this; call it yourself to read matrices of transforms moved since the last draw):
+	void update_transforms() const;
+	//counts the update_transforms passes, so every transform gets visited once per pass:
+	mutable uint32_t transform_pass = 0;
+	static void update_transform(Transform const &transform, uint32_t pass);
+
 	//Scenes, of course, may have many of the above objects:
-	std::list< Transform > transforms;
-	std::list< Drawable > drawables;
-	std::list< Camera > cameras;
-	std::list< Light > lights;
+	// (slot maps keep pointers to them stable; handles additionally notice when an object was removed)
+	SlotMap< Transform > transforms;
+	SlotMap< Drawable > drawables;
+	SlotMap< Camera > cameras;
+	SlotMap< Light > lights;
+	typedef SlotMap< Transform >::Handle TransformHandle;
+	typedef SlotMap< Drawable >::Handle DrawableHandle;
 
 	//The "draw" function provides a convenient way to pass all the things in a scene to OpenGL:
 	void draw(Camera const &camera) const;
@@ -129,6 +186,19 @@ struct Scene {
 	//..sometimes, you want to draw with a custom projection matrix and/or light space:
 	void draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light = glm::mat4x3(1.0f)) const;
 
+	//draw skips drawables whose bounds are outside the view,
+	// sorts the rest by program, vao, textures and (front-to-back) depth, and only binds what changes:
+	// these count what the last draw call did and which binds the sorting saved
+	struct DrawStats {
+		uint32_t drawables = 0; //instances included
+		uint32_t culled = 0; //drawables whose bounds were outside the view
+		uint32_t draw_calls = 0;
+		uint32_t program_binds = 0, program_binds_skipped = 0;
+		uint32_t vao_binds = 0, vao_binds_skipped = 0;
+		uint32_t texture_binds = 0, texture_binds_skipped = 0; //(un-binds included)
+	};
+	mutable DrawStats draw_stats;
+
 	//add transforms/objects/cameras from a scene file to this scene:
 	// the 'on_drawable' callback gives your code a chance to look up mesh data and make Drawables:
 	// throws on file format errors
@@ -146,5 +216,7 @@ struct Scene {
 	Scene(Scene const &); //...as a constructor
 	Scene &operator=(Scene const &); //...as scene = scene
 	//... as a set() function that optionally returns the transform->transform mapping:
-	void set(Scene const &, std::unordered_map< Transform const *, Transform * > *transform_map = nullptr);
+	// (indexed by slot index in the other scene, see SlotMap::index_of)
+	// throws std::out_of_range if something in the other scene points at a transform that isn't one of its own
+	void set(Scene const &, std::vector< Transform * > *transform_map = nullptr);
 };
@@ -0,0 +1,192 @@
+#pragma once
+
+/*
+ * A SlotMap keeps objects in fixed-size blocks of slots:
+ *  - objects never move once created, so pointers to them stay good until they're removed
+ *  - iterating walks the blocks in order instead of chasing list nodes
+ *  - slots of removed objects get reused, without another allocation
+ *
+ * Every slot counts how often its object was removed (its 'generation'), so a Handle
+ * (slot index + generation) can tell that the object it was made for is gone.
+ *
+ * Blocks aren't packed: removed objects leave free slots behind until they're reused.
+ * Looking up a pointer (index_of, handle_of, remove) checks that it is a live object of
+ * this map, and throws std::out_of_range otherwise.
+ *
+ */
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template< typename T >
+struct SlotMap {
+	struct Handle {
+		uint32_t index = -1U;
+		uint32_t generation = 0;
+		bool operator==(Handle const &other) const { return index == other.index && generation == other.generation; }
+		bool operator!=(Handle const &other) const { return !(*this == other); }
+	};
+
+	SlotMap() = default;
+	~SlotMap() { clear(); }
+	//objects may hold pointers to each other, so copying is up to the owner (see Scene::set):
+	SlotMap(SlotMap const &) = delete;
+	SlotMap &operator=(SlotMap const &) = delete;
+
+	//construct an object in a free slot (named after std::list::emplace_back, which this replaces):
+	template< typename... Args >
+	T &emplace_back(Args &&... args);
+	//the object created most recently (n.b. not necessarily the last one iterated over):
+	T &back() { assert(last != -1U && slot(last).alive); return slot(last).get(); }
+	T const &back() const { assert(last != -1U && slot(last).alive); return slot(last).get(); }
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	//slots handed out so far; every index is below this:
+	uint32_t slot_count() const { return slots; }
+
+	void remove(T const *object);
+	template< typename Pred >
+	void remove_if(Pred const &pred);
+	void clear();
+
+	Handle handle_of(T const *object) const { Slot const &s = slot_of(object); return Handle{ s.index, s.generation }; }
+	uint32_t index_of(T const *object) const { return slot_of(object).index; }
+	//null if the handle's object has been removed:
+	T *get(Handle handle);
+	T const *get(Handle handle) const { return const_cast< SlotMap * >(this)->get(handle); }
+	//the object in a slot, or null if the slot is free:
+	T *at_index(uint32_t index) { return index < slots && slot(index).alive ? &slot(index).get() : nullptr; }
+	T const *at_index(uint32_t index) const { return const_cast< SlotMap * >(this)->at_index(index); }
+
+	//iterates over the objects in slot order:
+	template< typename Map, typename Value >
+	struct Iterator {
+		Map *map;
+		uint32_t index;
+		Iterator(Map *map_, uint32_t index_) : map(map_), index(index_) { skip_free(); }
+		void skip_free() { while (index < map->slots && !map->slot(index).alive) ++index; }
+		Value &operator*() const { return map->slot(index).get(); }
+		Value *operator->() const { return &map->slot(index).get(); }
+		Iterator &operator++() { ++index; skip_free(); return *this; }
+		bool operator==(Iterator const &other) const { return index == other.index; }
+		bool operator!=(Iterator const &other) const { return index != other.index; }
+	};
+	typedef Iterator< SlotMap, T > iterator;
+	typedef Iterator< SlotMap const, T const > const_iterator;
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, slots); }
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, slots); }
+
+	//-- internals --
+
+	enum : uint32_t { BlockSize = 256 };
+	struct Slot {
+		//first, so a pointer to the object is a pointer to its slot:
+		typename std::aligned_storage< sizeof(T), alignof(T) >::type storage;
+		uint32_t index = 0;
+		uint32_t generation = 0;
+		bool alive = false;
+		T &get() { return *reinterpret_cast< T * >(&storage); }
+		T const &get() const { return *reinterpret_cast< T const * >(&storage); }
+	};
+	static_assert(std::is_standard_layout< Slot >::value, "Slot is standard layout, so storage sits at its start.");
+
+	std::vector< std::unique_ptr< Slot[] > > blocks;
+	std::vector< uint32_t > free_slots;
+	uint32_t slots = 0;
+	size_t count = 0;
+	uint32_t last = -1U;
+
+	Slot &slot(uint32_t index) { return blocks[index / BlockSize][index % BlockSize]; }
+	Slot const &slot(uint32_t index) const { return blocks[index / BlockSize][index % BlockSize]; }
+	//the slot holding 'object', which has to be alive and in this map:
+	Slot const &slot_of(T const *object) const;
+	Slot &slot_of(T const *object) { return const_cast< Slot & >(static_cast< SlotMap const * >(this)->slot_of(object)); }
+	void remove_slot(Slot &s);
+};
+
+template< typename T >
+typename SlotMap< T >::Slot const &SlotMap< T >::slot_of(T const *object) const {
+	//(compared as addresses: the pointer may come from anywhere)
+	uintptr_t address = reinterpret_cast< uintptr_t >(object);
+	for (auto const &block : blocks) {
+		uintptr_t first = reinterpret_cast< uintptr_t >(block.get());
+		if (address < first || address >= first + BlockSize * sizeof(Slot)) continue;
+		if ((address - first) % sizeof(Slot) != 0) break;
+		Slot const &s = block[(address - first) / sizeof(Slot)];
+		if (!s.alive) break;
+		return s;
+	}
+	throw std::out_of_range("SlotMap: not an object of this map");
+}
+
+template< typename T >
+template< typename... Args >
+T &SlotMap< T >::emplace_back(Args &&... args) {
+	uint32_t index;
+	if (!free_slots.empty()) {
+		index = free_slots.back();
+	} else {
+		if (slots == blocks.size() * BlockSize) blocks.emplace_back(new Slot[BlockSize]);
+		index = slots;
+	}
+	Slot &s = slot(index);
+	new (&s.storage) T(std::forward< Args >(args)...);
+	//(only claim the slot once the constructor didn't throw)
+	if (index == slots) ++slots;
+	else free_slots.pop_back();
+	s.index = index;
+	s.alive = true;
+	++count;
+	last = index;
+	return s.get();
+}
+
+template< typename T >
+void SlotMap< T >::remove(T const *object) {
+	remove_slot(slot_of(object));
+}
+
+template< typename T >
+void SlotMap< T >::remove_slot(Slot &s) {
+	assert(s.alive);
+	s.get().~T();
+	s.alive = false;
+	++s.generation;
+	free_slots.push_back(s.index);
+	--count;
+	if (last == s.index) last = -1U;
+}
+
+template< typename T >
+template< typename Pred >
+void SlotMap< T >::remove_if(Pred const &pred) {
+	for (uint32_t index = 0; index < slots; ++index) {
+		Slot &s = slot(index);
+		if (s.alive && pred(s.get())) remove_slot(s);
+	}
+}
+
+template< typename T >
+void SlotMap< T >::clear() {
+	for (uint32_t index = 0; index < slots; ++index) {
+		Slot &s = slot(index);
+		if (s.alive) remove_slot(s);
+	}
+}
+
+template< typename T >
+T *SlotMap< T >::get(Handle handle) {
+	if (handle.index >= slots) return nullptr;
+	Slot &s = slot(handle.index);
+	if (!s.alive || s.generation != handle.generation) return nullptr;
+	return &s.get();
+}
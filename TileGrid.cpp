@@ -0,0 +1,1663 @@
+#include "TileGrid.hpp"
+#include "WorkerPool.hpp"
+#include "read_write_chunk.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <algorithm>
+#include <limits>
+
+// the aura passes use SSE when it's there (always on x86-64)
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#define TILEGRID_SSE
+#include <xmmintrin.h>
+#endif
+
+PlantType const* test_plant = nullptr;
+PlantType const* friend_plant = nullptr;
+PlantType const* vampire_plant = nullptr;
+PlantType const* cactus_plant = nullptr;
+PlantType const* fireflower_plant = nullptr;
+PlantType const* waterflower_plant = nullptr;
+PlantType const* beaconflower_plant = nullptr;
+PlantType const* corpseeater_plant = nullptr;
+PlantType const* spreader_source_plant = nullptr;
+PlantType const* spreader_child_plant = nullptr;
+PlantType const* teleporter_plant = nullptr;
+std::vector< PlantType const* > all_plants;
+std::vector< GroundTileType const* > all_tile_types;
+GroundTileType const* sea_tile = nullptr;
+GroundTileType const* ground_tile = nullptr;
+GroundTileType const* dirt_tile = nullptr;
+GroundTileType const* grass_short_tile = nullptr;
+GroundTileType const* grass_tall_tile = nullptr;
+GroundTileType const* empty_tile = nullptr;
+GroundTileType const* border_tile = nullptr;
+
+void create_plant_types()
+{
+	if( test_plant ) return;
+
+	ground_tile = new GroundTileType( true, -1 );
+	dirt_tile = new GroundTileType( false, 40 );
+	grass_short_tile = new GroundTileType( false, 50 );
+	grass_tall_tile = new GroundTileType( false, 60 );
+	empty_tile = new GroundTileType( false, -1 );
+	border_tile = new GroundTileType( false, -1 );
+
+	all_tile_types.push_back( ground_tile );
+	all_tile_types.push_back( dirt_tile );
+	all_tile_types.push_back( grass_short_tile );
+	all_tile_types.push_back( grass_tall_tile );
+	all_tile_types.push_back( empty_tile );
+
+	// stage counts match the number of meshes each plant has (see Plant.cpp)
+	test_plant = new PlantType( 2, AuraKind::none, 5, 0, 20.0f, "Familiar Fern", 
+								"Cheap plant. Grows anywhere." );
+	friend_plant = new PlantType( 3, AuraKind::help, 10, 0, 30.0f, "Companion Carrot", 
+								  "Speeds up growth of adjacent plants. Needs 2 neighbors to grow." );
+	vampire_plant = new PlantType( 3, AuraKind::suck, 20, 0, 50.0f, "Sap Sucker", 
+								   "Grows by stealing life from adjacent plants. 3 plants sustain it." );
+	cactus_plant = new PlantType( 3, AuraKind::none, 10, 0, 60.0f, "Crisp Cactus", 
+								  "Grows only in fire aura from fire flowers." );
+	fireflower_plant = new PlantType( 3, AuraKind::fire, 5, 0, 20.0f, "Fire Flower", 
+									  "Gives off fire aura." );
+	waterflower_plant = new PlantType( 3, AuraKind::aqua, 5, 0, 20.0f, "Sieve Flower", 
+									  "Gives off aqua aura." );
+	beaconflower_plant = new PlantType( 3, AuraKind::beacon, 20, 0, 40.0f, "Beacon Flower", 
+									  "Gives off whatever aura it is planted in." );								  
+	corpseeater_plant = new PlantType( 3, AuraKind::none, 5, 0, 40.0f, "Detritus Dahlia", 
+									   "Feeds off an adjacent dead plant." );
+	spreader_source_plant = new PlantType( 2, AuraKind::none, 5, 0, 10.0f, "Spreading Sage", 
+										   "Once fully grown tries to spread all over the farm." );
+	spreader_child_plant = new PlantType( 2, AuraKind::none, 5, 0, 5.0f, "Spreading Sage Child", 
+										  "Offshoot of the Spreading Sage" );
+	teleporter_plant = new PlantType( 3, AuraKind::none, 5, 0, 40.0f, "Teleporting Twinleaf", 
+									  "Teleports around the field while growing." );
+
+	all_plants.push_back(test_plant);
+	all_plants.push_back(friend_plant);
+	all_plants.push_back(vampire_plant);
+	all_plants.push_back(cactus_plant);
+	all_plants.push_back(fireflower_plant);
+	all_plants.push_back(waterflower_plant);
+	all_plants.push_back(beaconflower_plant);
+	all_plants.push_back(corpseeater_plant);
+	all_plants.push_back(spreader_source_plant);
+	all_plants.push_back( spreader_child_plant );
+	all_plants.push_back(teleporter_plant);
+
+	assert( all_plants.size() == plant_type_count && "plant_type_count matches all_plants" );
+	for( size_t i = 0; i < all_plants.size(); ++i )
+	{
+		const_cast< PlantType* >( all_plants[i] )->id = int( i );
+	}
+}
+
+void tune_plant_type( PlantType const* plant, int cost, float growth_time )
+{
+	assert( plant && growth_time > 0.0f );
+	PlantType* tuned = const_cast< PlantType* >( plant );
+	tuned->cost = cost;
+	tuned->growth_time = growth_time;
+}
+
+char const* const starting_island =
+	"oodddddooo"
+	"oddxXxxddo"
+	"dxxXXXxxdo"
+	"odxxXxxxdd"
+	"dxxxCCxxxd"
+	"dxxxCCxxxd"
+	"dxxxxxxxdo"
+	"odxxXXxdoo"
+	"odxdxXXxdo"
+	"oododdddoo";
+
+GroundTileType const* get_island_tile_type( char c )
+{
+	if( c == 'x' ) return grass_short_tile;
+	if( c == 'X' ) return grass_tall_tile;
+	if( c == 'd' ) return dirt_tile;
+	if( c == 'C' ) return ground_tile;
+	return empty_tile;
+}
+
+void GroundTile::change_tile_type( const GroundTileType* tile_type_in )
+{
+	if( tile_type_in )
+	{
+		grid->catch_up( index );
+		tile_type = tile_type_in;
+		grid->aura_receiver[index] = tile_type->get_can_plant() ? 1.0f : 0.0f;
+		moisture() = 1.0f;
+		grid->update_tile_indices( index );
+		wake();
+		grid->record_change( TileChange::tile_type, index );
+	}
+	else
+	{
+		printf( "ERROR Passed in null tile type! \n" );
+	}
+}
+
+void GroundTile::update( float elapsed )
+{
+	shake = glm::mix( shake, 0.0f, 0.05f );
+
+	// references into the hot columns of the grid
+	float& current_grow_time = this->current_grow_time();
+	float& fertilization = this->fertilization();
+	float fire_aura_effect = this->fire_aura_effect();
+	float aqua_aura_effect = this->aqua_aura_effect();
+	TileGrid::PendingAction& action = grid->pending_actions[index];
+
+	// neighbors in TileGrid::neighbor_dx/dy order (border sentinels outside of the grid)
+	GroundTile* neighbors[TileGrid::neighbor_count];
+	for( int n = 0; n < TileGrid::neighbor_count; ++n )
+	{
+		neighbors[n] = &grid->get_neighbor( index, n );
+	}
+
+	// update plant state
+	if( plant_type )
+	{
+		float grow_power = elapsed * std::sqrt(plant_health());
+
+		if( !is_plant_dead() )
+		{
+			// PLANT BEHAVIORS -----------------------------------------------------------------------------------
+			if( plant_type == test_plant )
+			{
+				current_grow_time += grow_power + elapsed * std::sqrt(moisture());
+			}
+			else if( plant_type == friend_plant )
+			{
+				int neighbor = 0;
+				for( int n = 0; n < TileGrid::neighbor_count; ++n )
+				{
+					GroundTile* tile = neighbors[n];
+					if( tile->plant_type && !tile->is_plant_dead() )
+					{
+						neighbor++;
+						//Boost the neighbor
+						queue_neighbor_grow( n, elapsed * 0.4f );
+					}
+				}
+
+				if( neighbor >= 2 )
+				{
+					current_grow_time += grow_power + elapsed * std::sqrt(moisture());
+				}
+				else
+				{
+					queue_change_health( - elapsed * ( plant_health_restore_rate + 0.1f ) );
+				}
+			}
+			else if( plant_type == vampire_plant )
+			{
+				int victims[TileGrid::neighbor_count];
+				int victim_count = 0;
+
+				for( int n = 0; n < TileGrid::neighbor_count; ++n )
+				{
+					GroundTile* tile = neighbors[n];
+					if( tile->plant_type && !tile->is_plant_dead() )
+					{
+						victims[victim_count++] = n;
+					}
+				}
+
+				if( victim_count > 0 )
+				{
+					queue_neighbor_change_health( victims[next_random() % victim_count], - elapsed * ( 2*plant_health_restore_rate + 0.2f ) );
+					current_grow_time += grow_power + elapsed * std::sqrt(moisture());
+				}
+				else
+				{
+					queue_change_health( - elapsed * ( plant_health_restore_rate + 0.1f ) );
+				}
+			}
+			else if( plant_type == corpseeater_plant )
+			{
+				int dead_plants = 0;
+
+				for( int n = 0; n < TileGrid::neighbor_count; ++n )
+				{
+					GroundTile* tile = neighbors[n];
+					if( tile->plant_type && tile->is_plant_dead() )
+					{
+						dead_plants++;
+					}
+				}
+
+				if( dead_plants > 0 )
+				{
+					current_grow_time += grow_power + elapsed * std::sqrt(moisture());
+				}
+				else
+				{
+					queue_change_health( - elapsed * ( plant_health_restore_rate + 0.1f ) );
+				}
+			}
+			else if( plant_type == fireflower_plant )
+			{
+				current_grow_time += grow_power + elapsed;
+			}
+			else if( plant_type == waterflower_plant )
+			{
+				current_grow_time += grow_power + elapsed;
+			}
+			else if ( plant_type == beaconflower_plant ) 
+			{				
+				current_grow_time += grow_power + elapsed;
+			}
+			else if( plant_type == cactus_plant )
+			{
+				if( fire_aura_effect > 0.1f && aqua_aura_effect <= 0.0f )
+				{
+					current_grow_time += grow_power * fire_aura_effect + elapsed;
+				}
+				else
+				{
+					queue_change_health( - elapsed * ( plant_health_restore_rate + 0.1f ) );
+				}
+			}
+			else if( plant_type == teleporter_plant )
+			{
+				// teleports on each stage event (see TileGrid::resolve_pending_actions)
+				current_grow_time += grow_power + elapsed;
+			}
+			else if( plant_type == spreader_source_plant || plant_type == spreader_child_plant)
+			{
+				// Damage non spreader plants if trapped (no free neighbor)
+				if( !grid->free_neighbors[index] )
+				{
+					for( int n = 0; n < TileGrid::neighbor_count; ++n )
+					{
+						const PlantType* plant = neighbors[n]->plant_type;
+						if( plant && plant != spreader_child_plant && plant != spreader_source_plant )
+						{
+							queue_neighbor_change_health( n, -elapsed * ( plant_health_restore_rate + 0.1f ) );
+						}
+					}
+					// dead neighbors get dug out once the damage has been applied
+					action.trapped = true;
+				}
+
+				//Spawn new spreaders on growth (stage events), and all the time once the source is grown
+				current_grow_time += grow_power + elapsed;
+				if( is_tile_harvestable() && plant_type == spreader_source_plant )
+				{
+					action.spawn_neighbor = pick_free_neighbor();
+				}
+			}
+			// PLANT BEHAVIORS END -----------------------------------------------------------------------------------
+
+			queue_change_health( elapsed * plant_health_restore_rate );
+		}
+
+		fertilization = std::max(0.0f,fertilization - elapsed);
+		if( fertilization > 0.0f ) queue_change_health( elapsed * plant_health_fertilization_restore_rate );
+
+		float target_time = plant_type->get_growth_time();
+		if( current_grow_time > target_time ) current_grow_time = target_time;
+	}
+
+	// give off fire & aqua aura (spread onto the neighbors by TileGrid::update_auras)
+	AuraKind::Type aura_type = get_emitted_aura();
+	if( aura_type != AuraKind::none )
+	{
+		emit_aura( aura_type, plant_type->get_aura_type() == AuraKind::beacon );
+	}
+
+	// moisture drying and aura spread & decay run afterwards as dense passes (see TileGrid::update)
+}
+
+AuraKind::Type GroundTile::get_emitted_aura()
+{
+	if( !plant_type || is_plant_dead() ) return AuraKind::none;
+	// Beaconflower preprocessing
+	AuraKind::Type aura_type = plant_type->get_aura_type();
+	if( aura_type == AuraKind::beacon )
+	{
+		float fire_aura_effect = this->fire_aura_effect();
+		float aqua_aura_effect = this->aqua_aura_effect();
+		bool fire_apply = fire_aura_effect > 0.1f && fire_aura_effect > aqua_aura_effect;
+		bool water_apply = aqua_aura_effect > 0.1f && aqua_aura_effect > fire_aura_effect;
+		aura_type = fire_apply ? AuraKind::fire : ( water_apply ? AuraKind::aqua : AuraKind::none );
+	}
+	// the rest of aura types are decorations only
+	return aura_type == AuraKind::fire || aura_type == AuraKind::aqua ? aura_type : AuraKind::none;
+}
+
+void GroundTile::wake()
+{
+	grid->wake( index );
+	// the plant or tile type changed, the tile may have been awake but self-contained until now
+	grid->wake_parked_neighbors( index );
+}
+
+void GroundTile::queue_change_health( float change )
+{
+	grid->pending_update.plant_health[TileGrid::self_slot][index] += change;
+}
+
+void GroundTile::queue_neighbor_change_health( int neighbor, float change )
+{
+	grid->pending_actions[index].wake_neighbors |= uint8_t( 1 << neighbor );
+	grid->pending_update.plant_health[TileGrid::opposite_neighbor( neighbor )][grid->get_neighbor_index( index, neighbor )] += change;
+}
+
+void GroundTile::queue_neighbor_grow( int neighbor, float change )
+{
+	grid->pending_actions[index].wake_neighbors |= uint8_t( 1 << neighbor );
+	grid->pending_update.current_grow_time[TileGrid::opposite_neighbor( neighbor )][grid->get_neighbor_index( index, neighbor )] += change;
+}
+
+void GroundTile::emit_aura( AuraKind::Type aura_type, bool from_beacon )
+{
+	TileGrid::PendingAction& action = grid->pending_actions[index];
+	if( from_beacon && grid->beacon_aura_radius > 1 )
+	{
+		// woken and spread on by TileGrid::spread_wide_auras
+		action.wide_aura = aura_type;
+		return;
+	}
+	( aura_type == AuraKind::fire ? grid->fire_emitter : grid->aqua_emitter )[index] = 1.0f;
+	for( int n = 0; n < TileGrid::neighbor_count; ++n )
+	{
+		if( grid->aura_receiver[grid->get_neighbor_index( index, n )] > 0.0f )
+		{
+			action.wake_neighbors |= uint8_t( 1 << n );
+		}
+	}
+}
+
+uint32_t GroundTile::next_random()
+{
+	return xorshift32( grid->random_state[index] );
+}
+
+// set bits in a neighbor mask
+static const uint8_t neighbor_mask_count[1 << TileGrid::neighbor_count] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+int8_t GroundTile::pick_free_neighbor()
+{
+	// pick-th set bit, in neighbor order
+	uint8_t free = grid->free_neighbors[index];
+	if( !free ) return -1;
+	int pick = int( next_random() % uint32_t( neighbor_mask_count[free] ) );
+	for( int n = 0; n < TileGrid::neighbor_count; ++n )
+	{
+		if( !( free & ( 1 << n ) ) ) continue;
+		if( pick-- == 0 ) return int8_t( n );
+	}
+	return -1;
+}
+
+bool GroundTile::try_swap_plants(GroundTile& tile_a, GroundTile& tile_b )
+{
+	if( tile_a.is_cleared() && tile_b.is_cleared() )
+	{
+		tile_a.grid->catch_up( tile_a.index );
+		tile_b.grid->catch_up( tile_b.index );
+		const PlantType* swap_type = tile_b.plant_type;
+		float swap_health = tile_b.plant_health();
+		float swap_growth_time = tile_b.current_grow_time();
+		tile_b.plant_type = tile_a.plant_type;
+		tile_b.plant_health() = tile_a.plant_health();
+		tile_b.current_grow_time() = tile_a.current_grow_time();
+		tile_a.plant_type = swap_type;
+		tile_a.plant_health() = swap_health;
+		tile_a.current_grow_time() = swap_growth_time;
+		// the timeline moves with the plant
+		TileGrid& grid = *tile_a.grid;
+		std::swap( grid.next_event_grow_time[tile_a.index], grid.next_event_grow_time[tile_b.index] );
+		std::swap( grid.plant_stage[tile_a.index], grid.plant_stage[tile_b.index] );
+		std::swap( grid.plant_events[tile_a.index], grid.plant_events[tile_b.index] );
+		std::swap( grid.previous_grow_time[tile_a.index], grid.previous_grow_time[tile_b.index] );
+		grid.update_tile_indices( tile_a.index );
+		grid.update_tile_indices( tile_b.index );
+		tile_a.wake();
+		tile_b.wake();
+		grid.record_change( TileChange::plant, tile_a.index );
+		grid.record_change( TileChange::plant, tile_b.index );
+		return true;
+	}
+	return false;
+}
+
+bool GroundTile::try_add_plant( const PlantType* plant_type_in )
+{
+	// If we can plant on the tile and there is no plant already there, add a plant
+	grid->catch_up( index );
+	if( can_plant() )
+	{
+		if( !plant_type || try_remove_plant() )
+		{
+			plant_type = plant_type_in;
+			current_grow_time() = 0.0f;
+			grid->previous_grow_time[index] = 0.0f;
+			plant_health() = 1.0f;
+			grid->plant_stage[index] = 0;
+			grid->next_event_grow_time[index] = plant_type->get_stage_grow_time( 1 );
+			grid->plant_events[index] = 0;
+			grid->update_tile_indices( index );
+			wake();
+			grid->record_change( TileChange::plant, index );
+			return true;
+		}
+	}
+	return false;
+}
+
+bool GroundTile::try_remove_plant()
+{
+	// If there is a plant on tile, kick it out
+	if( plant_type )
+	{
+		grid->catch_up( index );
+		plant_type = nullptr;
+		grid->update_tile_indices( index );
+		grid->record_change( TileChange::plant, index );
+		return true;
+	}
+	return false;
+}
+
+bool GroundTile::is_tile_harvestable()
+{
+	return plant_type && current_grow_time() >= plant_type->get_growth_time() && !is_plant_dead();
+}
+
+bool GroundTile::is_plant_dead()
+{
+	return plant_type && plant_health() <= 0.0f;
+}
+
+bool GroundTile::can_plant()
+{
+	return tile_type->get_can_plant() && (!plant_type || is_plant_dead());
+}
+
+bool GroundTile::can_be_cleared() const
+{
+	bool has_cleared_neighbor = false;
+	for( int n = 0; n < TileGrid::neighbor_count; ++n )
+	{
+		if( grid->get_neighbor( index, n ).is_cleared() )
+		{
+			has_cleared_neighbor = true;
+			break;
+		}
+	}
+
+	return has_cleared_neighbor && tile_type->get_clear_cost() > 0;
+}
+
+bool GroundTile::try_clear_tile()
+{
+	change_tile_type( ground_tile );
+	return true;
+}
+
+bool GroundTile::is_cleared() const
+{
+	return tile_type == ground_tile;
+}
+
+bool GroundTile::is_free() const
+{
+	return grid->free_tiles.contains( index );
+}
+
+void GroundTile::change_health( float change )
+{
+	if( plant_type && !is_plant_dead() )
+	{
+		float& plant_health = this->plant_health();
+		plant_health = glm::clamp( plant_health + change, 0.0f, 1.0f );
+		if( is_plant_dead() )
+		{
+			grid->plant_events[index] |= TileGrid::death_event;
+			grid->record_change( TileChange::died, index );
+		}
+	}
+}
+
+void GroundTile::clear_auras()
+{
+	fire_aura_effect() = 0.0f;
+	aqua_aura_effect() = 0.0f;
+	grid->fire_emitter[index] = 0.0f;
+	grid->aqua_emitter[index] = 0.0f;
+	grid->check_aura( index );
+}
+
+const int TileGrid::neighbor_dx[TileGrid::neighbor_count] = { -1, 0, 0, 1 };
+const int TileGrid::neighbor_dy[TileGrid::neighbor_count] = { 0, -1, 1, 0 };
+
+void TileGrid::resize( int size_x_in, int size_y_in )
+{
+	assert( border_tile && "create_plant_types() before resizing a grid" );
+	size_x = size_x_in;
+	size_y = size_y_in;
+	stride = size_y + 2;
+	size_t count = size_t( size_x + 2 ) * size_t( stride );
+	for( int n = 0; n < neighbor_count; ++n )
+	{
+		neighbor_offset[n] = neighbor_dx[n] * stride + neighbor_dy[n];
+	}
+
+	tiles.assign( count, GroundTile() );
+	plant_health.assign( count, 1.0f );
+	moisture.assign( count, 1.0f );
+	fertilization.assign( count, 0.0f );
+	fire_aura_effect.assign( count, 0.0f );
+	aqua_aura_effect.assign( count, 0.0f );
+	current_grow_time.assign( count, 0.0f );
+	random_state.resize( count );
+	previous_grow_time.assign( count, 0.0f );
+	next_event_grow_time.assign( count, 0.0f );
+	plant_stage.assign( count, 0 );
+	plant_events.assign( count, 0 );
+	for( int slot = 0; slot < neighbor_count; ++slot )
+	{
+		pending_update.current_grow_time[slot].assign( count, 0.0f );
+	}
+	fire_emitter.assign( count, 0.0f );
+	aqua_emitter.assign( count, 0.0f );
+	aura_receiver.assign( count, 0.0f );
+	for( int slot = 0; slot < pending_slot_count; ++slot )
+	{
+		pending_update.plant_health[slot].assign( count, 0.0f );
+	}
+	pending_actions.assign( count, PendingAction() );
+	awake.assign( count, 0 );
+	active_tiles.clear();
+	parked_at.assign( count, -1.0f );
+	parked_tiles.clear();
+	settled.assign( count, 0 );
+	drying_since.assign( count, -1.0f );
+	settled_count = 0;
+	settled_tiles.clear();
+	step_marks.assign( count, 0 );
+	changed_tiles.clear();
+	cleared_tiles.resize( count );
+	free_tiles.resize( count );
+	free_neighbors.assign( count, 0 );
+	aura_shown.assign( count, 0 );
+	journal.clear();
+
+	seed_random( random_seed );
+
+	// border included, only the tiles inside wake up
+	for( int32_t x = -1; x <= size_x; ++x )
+	{
+		for( int32_t y = -1; y <= size_y; ++y )
+		{
+			GroundTile& tile = get_tile( x, y );
+			tile.grid = this;
+			tile.index = get_index( x, y );
+			tile.grid_x = x;
+			tile.grid_y = y;
+			if( is_in_grid( x, y ) )
+			{
+				wake( tile.index );
+			}
+			else
+			{
+				tile.tile_type = border_tile;
+			}
+		}
+	}
+}
+
+void TileGrid::seed_random( uint32_t seed )
+{
+	for( size_t i = 0; i < random_state.size(); ++i )
+	{
+		random_state[i] = mix_seed( seed, tile_stream_base + uint32_t( i ) );
+	}
+	teleport_random.set_seed( mix_seed( seed, teleport_stream ) );
+}
+
+struct GridSnapshotHeader
+{
+	uint32_t version = 0;
+	int32_t size_x = 0;
+	int32_t size_y = 0;
+	uint32_t teleport_random = 0;
+};
+static_assert( sizeof( GridSnapshotHeader ) == 16, "header is packed" );
+
+// Chunks, in order:
+//  grd0 header | tty0 tile type ids (index into all_tile_types) | pty0 plant ids (index into all_plants + 1, 0 is none)
+//  then the hot columns, the awake flags and the cleared/free index sets (their order picks teleport targets).
+//  Type ids only cover the tiles inside the grid (x-major), the columns are stored with their border
+void TileGrid::write_snapshot( std::ostream* to )
+{
+	GridSnapshotHeader header;
+	header.version = snapshot_version;
+	header.size_x = size_x;
+	header.size_y = size_y;
+	header.teleport_random = teleport_random.state;
+	write_chunk( "grd0", std::vector< GridSnapshotHeader >{ header }, to );
+
+	std::vector< uint8_t > tile_type_ids;
+	std::vector< uint8_t > plant_ids;
+	for( int32_t x = 0; x < size_x; ++x )
+	{
+		for( int32_t y = 0; y < size_y; ++y )
+		{
+			GroundTile& tile = get_tile( x, y );
+			tile_type_ids.emplace_back( uint8_t( std::find( all_tile_types.begin(), all_tile_types.end(), tile.tile_type ) - all_tile_types.begin() ) );
+			plant_ids.emplace_back( tile.plant_type ? uint8_t( tile.plant_type->get_id() + 1 ) : 0 );
+		}
+	}
+	write_chunk( "tty0", tile_type_ids, to );
+	write_chunk( "pty0", plant_ids, to );
+
+	write_chunk( "hlt0", plant_health, to );
+	write_chunk( "mst0", moisture, to );
+	write_chunk( "fer0", fertilization, to );
+	write_chunk( "fir0", fire_aura_effect, to );
+	write_chunk( "aqa0", aqua_aura_effect, to );
+	write_chunk( "grw0", current_grow_time, to );
+	write_chunk( "evt0", next_event_grow_time, to );
+	write_chunk( "stg0", plant_stage, to );
+	write_chunk( "rnd0", random_state, to );
+	write_chunk( "awk0", awake, to );
+	write_chunk( "clr0", cleared_tiles.indices, to );
+	write_chunk( "fre0", free_tiles.indices, to );
+}
+
+void TileGrid::read_snapshot( std::istream& from, GridSnapshot* snapshot ) const
+{
+	std::vector< GridSnapshotHeader > header;
+	read_chunk( from, "grd0", &header );
+	if( header.size() != 1 || header[0].version != snapshot_version )
+	{
+		throw std::runtime_error( "Unsupported grid snapshot version" );
+	}
+	// the grid view and the islands are built for the grid's size, so it stays as it is
+	if( header[0].size_x != size_x || header[0].size_y != size_y )
+	{
+		throw std::runtime_error( "Grid snapshot is for a grid of another size" );
+	}
+	snapshot->teleport_random = header[0].teleport_random;
+
+	// type ids cover the tiles inside the grid, the columns include the border
+	size_t count = tiles.size();
+	auto read_column = [&from]( std::string const& magic, auto* column, size_t column_size ) {
+		read_chunk( from, magic, column );
+		if( column->size() != column_size ) throw std::runtime_error( "Grid snapshot chunk '" + magic + "' has the wrong tile count" );
+	};
+
+	std::vector< uint8_t > tile_type_ids;
+	std::vector< uint8_t > plant_ids;
+	read_column( "tty0", &tile_type_ids, size_t( size_x ) * size_t( size_y ) );
+	read_column( "pty0", &plant_ids, size_t( size_x ) * size_t( size_y ) );
+	snapshot->tile_types.clear();
+	snapshot->plant_types.clear();
+	for( size_t id = 0; id < tile_type_ids.size(); ++id )
+	{
+		if( tile_type_ids[id] >= all_tile_types.size() || plant_ids[id] > all_plants.size() )
+		{
+			throw std::runtime_error( "Grid snapshot has an unknown tile or plant type" );
+		}
+		snapshot->tile_types.emplace_back( all_tile_types[tile_type_ids[id]] );
+		snapshot->plant_types.emplace_back( plant_ids[id] ? all_plants[plant_ids[id] - 1] : nullptr );
+	}
+
+	read_column( "hlt0", &snapshot->plant_health, count );
+	read_column( "mst0", &snapshot->moisture, count );
+	read_column( "fer0", &snapshot->fertilization, count );
+	read_column( "fir0", &snapshot->fire_aura_effect, count );
+	read_column( "aqa0", &snapshot->aqua_aura_effect, count );
+	read_column( "grw0", &snapshot->current_grow_time, count );
+	read_column( "evt0", &snapshot->next_event_grow_time, count );
+	read_column( "stg0", &snapshot->plant_stage, count );
+	read_column( "rnd0", &snapshot->random_state, count );
+	read_column( "awk0", &snapshot->awake, count );
+
+	read_chunk( from, "clr0", &snapshot->cleared_tiles );
+	read_chunk( from, "fre0", &snapshot->free_tiles );
+	for( std::vector< int > const* set : { &snapshot->cleared_tiles, &snapshot->free_tiles } )
+	{
+		for( int index : *set )
+		{
+			if( index < 0 || size_t( index ) >= count ) throw std::runtime_error( "Grid snapshot has a tile index out of range" );
+		}
+	}
+	for( int index : snapshot->free_tiles )
+	{
+		GroundTile const& tile = tiles[index];
+		if( !is_in_grid( tile.grid_x, tile.grid_y ) ) throw std::runtime_error( "Grid snapshot has a free border tile" );
+	}
+}
+
+void TileGrid::apply_snapshot( GridSnapshot& snapshot )
+{
+	teleport_random.state = snapshot.teleport_random;
+
+	size_t id = 0;
+	for( int32_t x = 0; x < size_x; ++x )
+	{
+		for( int32_t y = 0; y < size_y; ++y, ++id )
+		{
+			GroundTile& tile = get_tile( x, y );
+			tile.tile_type = snapshot.tile_types[id];
+			aura_receiver[tile.index] = tile.tile_type->get_can_plant() ? 1.0f : 0.0f;
+			tile.plant_type = snapshot.plant_types[id];
+			tile.shake = 0.0f;
+		}
+	}
+
+	plant_health = std::move( snapshot.plant_health );
+	moisture = std::move( snapshot.moisture );
+	fertilization = std::move( snapshot.fertilization );
+	fire_aura_effect = std::move( snapshot.fire_aura_effect );
+	aqua_aura_effect = std::move( snapshot.aqua_aura_effect );
+	current_grow_time = std::move( snapshot.current_grow_time );
+	next_event_grow_time = std::move( snapshot.next_event_grow_time );
+	plant_stage = std::move( snapshot.plant_stage );
+	random_state = std::move( snapshot.random_state );
+	awake = std::move( snapshot.awake );
+	size_t count = tiles.size();
+	previous_grow_time = current_grow_time;
+	plant_events.assign( count, 0 );
+
+	active_tiles.clear();
+	for( size_t i = 0; i < count; ++i )
+	{
+		if( awake[i] ) active_tiles.emplace_back( int( i ) );
+	}
+	active_tiles_sorted = true;
+
+	// the sets keep their order, only the positions get rebuilt
+	cleared_tiles.indices = std::move( snapshot.cleared_tiles );
+	free_tiles.indices = std::move( snapshot.free_tiles );
+	for( TileIndexSet* set : { &cleared_tiles, &free_tiles } )
+	{
+		set->positions.assign( count, -1 );
+		for( size_t i = 0; i < set->indices.size(); ++i )
+		{
+			set->positions[set->indices[i]] = int( i );
+		}
+	}
+	free_neighbors.assign( count, 0 );
+	for( int index : free_tiles.indices )
+	{
+		for( int n = 0; n < neighbor_count; ++n )
+		{
+			free_neighbors[get_neighbor_index( index, n )] |= uint8_t( 1 << opposite_neighbor( n ) );
+		}
+	}
+
+	aura_shown.assign( count, 0 );
+	for( int32_t x = 0; x < size_x; ++x )
+	{
+		for( int32_t y = 0; y < size_y; ++y )
+		{
+			int index = get_index( x, y );
+			record_change( TileChange::tile_type, index );
+			record_change( TileChange::plant, index );
+			check_aura( index );
+		}
+	}
+}
+
+void TileGrid::read_snapshot( std::istream& from )
+{
+	GridSnapshot snapshot;
+	read_snapshot( from, &snapshot );
+	apply_snapshot( snapshot );
+}
+
+void TileIndexSet::insert( int index )
+{
+	if( positions[index] >= 0 ) return;
+	positions[index] = int( indices.size() );
+	indices.push_back( index );
+}
+
+void TileIndexSet::erase( int index )
+{
+	int position = positions[index];
+	if( position < 0 ) return;
+	int last = indices.back();
+	indices[position] = last;
+	positions[last] = position;
+	indices.pop_back();
+	positions[index] = -1;
+}
+
+void TileGrid::update_tile_indices( int index )
+{
+	GroundTile& tile = tiles[index];
+	cleared_tiles.set( index, tile.is_cleared() );
+	set_free( index, tile.is_cleared() && !tile.plant_type );
+}
+
+void TileGrid::set_free( int index, bool free )
+{
+	if( free_tiles.contains( index ) == free ) return;
+	free_tiles.set( index, free );
+	// this tile is the opposite neighbor of each of its neighbors
+	for( int n = 0; n < neighbor_count; ++n )
+	{
+		uint8_t bit = uint8_t( 1 << opposite_neighbor( n ) );
+		uint8_t& mask = free_neighbors[get_neighbor_index( index, n )];
+		mask = free ? uint8_t( mask | bit ) : uint8_t( mask & ~bit );
+	}
+}
+
+bool TileGrid::is_in_grid( int x, int y ) const
+{
+	return x >= 0 && y >= 0 && x < size_x && y < size_y;
+}
+
+void TileGrid::wake( int index )
+{
+	if( awake[index] ) return;
+	awake[index] = 1;
+	if( !active_tiles.empty() && active_tiles.back() > index ) active_tiles_sorted = false;
+	active_tiles.push_back( index );
+
+	if( settled[index] ) unsettle( index );
+	if( parked_at[index] >= 0.0f )
+	{
+		catch_up( index );
+		parked_at[index] = -1.0f;
+		wake_parked_neighbors( index );
+	}
+}
+
+void TileGrid::wake_parked_neighbors( int index )
+{
+	// the tile may start to read or write its neighbors, so they have to be current as well
+	for( int n = 0; n < neighbor_count; ++n )
+	{
+		int neighbor = get_neighbor_index( index, n );
+		if( parked_at[neighbor] >= 0.0f ) wake( neighbor );
+	}
+}
+
+bool TileGrid::can_sleep( int index )
+{
+	GroundTile& tile = tiles[index];
+	bool moisture_settled = !tile.tile_type || !tile.tile_type->get_can_plant() || moisture[index] <= 0.0f;
+	return !tile.plant_type && fire_aura_effect[index] <= 0.0f && aqua_aura_effect[index] <= 0.0f && moisture_settled;
+}
+
+void TileGrid::record_change( TileChange::Kind kind, int index, int other_index )
+{
+	journal.push_back( { kind, index, other_index, fast_forwarding } );
+	if( !hold_changes ) flush_changes();
+}
+
+void TileGrid::flush_changes()
+{
+	// observers may change tiles in turn; those changes join the end of this batch
+	hold_changes++;
+	bool was_fast_forwarding = fast_forwarding;
+	for( size_t i = 0; i < journal.size(); ++i )
+	{
+		TileChange change = journal[i];
+		GroundTile& tile = tiles[change.index];
+		// skipped time stays quiet for the observers
+		fast_forwarding = change.skipped;
+		for( TileObserver* observer : observers )
+		{
+			switch( change.kind )
+			{
+			case TileChange::tile_type: observer->on_tile_type_changed( tile ); break;
+			case TileChange::plant: observer->on_plant_changed( tile ); break;
+			case TileChange::stage: observer->on_plant_stage_changed( tile ); break;
+			case TileChange::died: observer->on_plant_died( tile ); break;
+			case TileChange::aura: observer->on_aura_changed( tile ); break;
+			case TileChange::teleport: observer->on_teleport( tile, tiles[change.other_index] ); break;
+			case TileChange::asleep: observer->on_tile_asleep( tile ); break;
+			}
+		}
+	}
+	journal.clear();
+	fast_forwarding = was_fast_forwarding;
+	hold_changes--;
+}
+
+void TileGrid::check_aura( int index )
+{
+	uint8_t shown = uint8_t( ( fire_aura_effect[index] > 0.0f ? 1 : 0 ) | ( aqua_aura_effect[index] > 0.0f ? 2 : 0 ) );
+	if( shown == aura_shown[index] ) return;
+	aura_shown[index] = shown;
+	record_change( TileChange::aura, index );
+}
+
+void TileGrid::update( float elapsed )
+{
+	// the observers hear about this step once it's done
+	hold_changes++;
+
+	// tiles woken since the last update
+	if( !active_tiles_sorted )
+	{
+		std::sort( active_tiles.begin(), active_tiles.end() );
+		active_tiles_sorted = true;
+	}
+
+	for( int index : active_tiles ) previous_grow_time[index] = current_grow_time[index];
+
+	// tiles only write into their own pending slots, so they can update in any order
+	if( workers && active_tiles.size() >= min_parallel_tiles )
+	{
+		workers->run_ranges( active_tiles.size(), [this, elapsed]( size_t begin, size_t end ) {
+			for( size_t i = begin; i < end; ++i ) tiles[active_tiles[i]].update( elapsed );
+		} );
+	}
+	else
+	{
+		for( int index : active_tiles ) tiles[index].update( elapsed );
+	}
+
+	// sleeping neighbors that got written to join in for the passes below (settled ones don't,
+	// the writes can't change them)
+	size_t updated_count = active_tiles.size();
+	for( size_t i = 0; i < updated_count; ++i )
+	{
+		int index = active_tiles[i];
+		uint8_t wake_neighbors = pending_actions[index].wake_neighbors;
+		for( int n = 0; wake_neighbors; ++n, wake_neighbors >>= 1 )
+		{
+			int neighbor = get_neighbor_index( index, n );
+			if( ( wake_neighbors & 1 ) && !settled[neighbor] ) wake( neighbor );
+		}
+		if( pending_actions[index].wide_aura != AuraKind::none )
+		{
+			int r = beacon_aura_radius;
+			for( int dx = -r; dx <= r; ++dx )
+			{
+				for( int dy = std::abs( dx ) - r; dy <= r - std::abs( dx ); ++dy )
+				{
+					int x = tiles[index].grid_x + dx;
+					int y = tiles[index].grid_y + dy;
+					int target = get_index( x, y );
+					if( ( dx || dy ) && is_in_grid( x, y ) && aura_receiver[target] > 0.0f && !settled[target] ) wake( target );
+				}
+			}
+		}
+	}
+	if( !active_tiles_sorted )
+	{
+		std::sort( active_tiles.begin(), active_tiles.end() );
+		active_tiles_sorted = true;
+	}
+
+	update_tile_state( elapsed );
+	update_auras( elapsed );
+	spread_wide_auras( elapsed );
+	apply_pending_update( elapsed );
+	collect_plant_events();
+	resolve_pending_actions();
+	// auras only change on awake tiles, and none are left on tiles that go to sleep
+	for( int index : active_tiles ) check_aura( index );
+	put_tiles_to_sleep();
+
+	if( --hold_changes == 0 ) flush_changes();
+}
+
+void TileGrid::update_tile_state( float elapsed )
+{
+	float* moisture = this->moisture.data();
+
+	float dry = GroundTile::moisture_dry_rate * elapsed;
+	for( int i : active_tiles )
+	{
+		moisture[i] -= dry;
+	}
+}
+
+void TileGrid::update_auras( float elapsed )
+{
+	// aura = min( 1, max( 0, aura - decay ) + spread from each marked neighbor ) over the whole grid.
+	// Tiles without aura and without an emitting neighbor (everything that isn't awake) stay at 0.
+	// The neighbor terms get added in pending slot order, so this matches the old scattered writes exactly
+	float decay = aura_decay_rate * elapsed;
+	float spread = aura_spread_rate * elapsed;
+	const float* receiver = aura_receiver.data();
+	// the outer border tiles are skipped, their neighbors would be outside of the columns
+	int begin = stride;
+	int end = int( tiles.size() ) - stride;
+	int offset[neighbor_count];
+	for( int n = 0; n < neighbor_count; ++n ) offset[n] = neighbor_offset[n];
+
+	// with only a few tiles awake (say, most of them settled during fast_forward) it's cheaper to visit
+	// just those: they're the only ones that can change, same as in the dense pass
+	bool sparse = active_tiles.size() * 8 < tiles.size();
+
+	for( int field = 0; field < 2; ++field )
+	{
+		float* aura = field == 0 ? fire_aura_effect.data() : aqua_aura_effect.data();
+		const float* emitter = field == 0 ? fire_emitter.data() : aqua_emitter.data();
+		if( sparse )
+		{
+			for( int i : active_tiles )
+			{
+				float pending = 0.0f;
+				for( int n = 0; n < neighbor_count; ++n )
+				{
+					pending += emitter[i + offset[n]] * spread;
+				}
+				pending *= receiver[i];
+				aura[i] = std::min( 1.0f, std::max( 0.0f, aura[i] - decay ) + pending );
+			}
+			continue;
+		}
+		int i = begin;
+#ifdef TILEGRID_SSE
+		__m128 zero = _mm_setzero_ps();
+		__m128 one = _mm_set1_ps( 1.0f );
+		__m128 decay4 = _mm_set1_ps( decay );
+		__m128 spread4 = _mm_set1_ps( spread );
+		for( ; i + 4 <= end; i += 4 )
+		{
+			__m128 pending = zero;
+			for( int n = 0; n < neighbor_count; ++n )
+			{
+				pending = _mm_add_ps( pending, _mm_mul_ps( _mm_loadu_ps( emitter + i + offset[n] ), spread4 ) );
+			}
+			pending = _mm_mul_ps( pending, _mm_loadu_ps( receiver + i ) );
+			__m128 value = _mm_max_ps( _mm_sub_ps( _mm_loadu_ps( aura + i ), decay4 ), zero );
+			_mm_storeu_ps( aura + i, _mm_min_ps( _mm_add_ps( value, pending ), one ) );
+		}
+#endif
+		for( ; i < end; ++i )
+		{
+			float pending = 0.0f;
+			for( int n = 0; n < neighbor_count; ++n )
+			{
+				pending += emitter[i + offset[n]] * spread;
+			}
+			pending *= receiver[i];
+			aura[i] = std::min( 1.0f, std::max( 0.0f, aura[i] - decay ) + pending );
+		}
+	}
+
+	// the masks are used up, only tiles that updated can have set them
+	for( int i : active_tiles )
+	{
+		fire_emitter[i] = 0.0f;
+		aqua_emitter[i] = 0.0f;
+	}
+}
+
+void TileGrid::spread_wide_auras( float elapsed )
+{
+	if( beacon_aura_radius <= 1 ) return;
+
+	// beacons with a wider radius add to every plantable tile in reach (already woken in update)
+	float spread = aura_spread_rate * elapsed;
+	for( int index : active_tiles )
+	{
+		AuraKind::Type aura_type = pending_actions[index].wide_aura;
+		if( aura_type == AuraKind::none ) continue;
+		std::vector< float >& aura = aura_type == AuraKind::fire ? fire_aura_effect : aqua_aura_effect;
+		int r = beacon_aura_radius;
+		for( int dx = -r; dx <= r; ++dx )
+		{
+			for( int dy = std::abs( dx ) - r; dy <= r - std::abs( dx ); ++dy )
+			{
+				int x = tiles[index].grid_x + dx;
+				int y = tiles[index].grid_y + dy;
+				if( !( dx || dy ) || !is_in_grid( x, y ) ) continue;
+				int target = get_index( x, y );
+				aura[target] = std::min( 1.0f, aura[target] + spread * aura_receiver[target] );
+			}
+		}
+	}
+}
+
+void TileGrid::apply_pending_update( float elapsed )
+{
+	float* moisture = this->moisture.data();
+	float* fire = fire_aura_effect.data();
+	float* aqua = aqua_aura_effect.data();
+
+	// move update from pending_update, always summing the slots in the same order
+	// (only active tiles and the neighbors they woke can have anything pending).
+	// Auras are already spread at this point
+	for( int i : active_tiles )
+	{
+		moisture[i] += aqua[i] * elapsed * 0.25f;
+		moisture[i] -= fire[i] * elapsed * 0.25f;
+		moisture[i] = std::min( 1.0f, std::max( 0.0f, moisture[i] ) );
+	}
+
+	// plant changes go through the tile so deaths get noticed
+	for( int i : active_tiles )
+	{
+		GroundTile& tile = tiles[i];
+
+		float pending_grow = 0.0f;
+		for( int slot = 0; slot < neighbor_count; ++slot )
+		{
+			pending_grow += pending_update.current_grow_time[slot][i];
+			pending_update.current_grow_time[slot][i] = 0.0f;
+		}
+		if( tile.plant_type )
+		{
+			current_grow_time[i] = std::min( tile.plant_type->get_growth_time(), current_grow_time[i] + pending_grow );
+		}
+
+		for( int slot = 0; slot < pending_slot_count; ++slot )
+		{
+			float change = pending_update.plant_health[slot][i];
+			if( change == 0.0f ) continue;
+			pending_update.plant_health[slot][i] = 0.0f;
+			tile.change_health( change );
+			// hurt by a neighbor
+			if( slot != self_slot && change < 0.0f ) tile.shake = 0.01f;
+		}
+	}
+}
+
+void TileGrid::collect_plant_events()
+{
+	for( int i : active_tiles )
+	{
+		collect_plant_event( i );
+	}
+}
+
+void TileGrid::collect_plant_event( int i )
+{
+	const PlantType* plant_type = tiles[i].plant_type;
+	if( !plant_type || current_grow_time[i] < next_event_grow_time[i] ) return;
+
+	float target_time = plant_type->get_growth_time();
+	int stage = plant_type->get_growth_stage( current_grow_time[i] / target_time );
+	if( stage > plant_stage[i] )
+	{
+		plant_stage[i] = int8_t( stage );
+		plant_events[i] |= stage_event;
+	}
+	if( current_grow_time[i] >= target_time )
+	{
+		plant_events[i] |= harvestable_event;
+		next_event_grow_time[i] = std::numeric_limits< float >::infinity();
+	}
+	else
+	{
+		// if rounding kept the stage back, this checks again next update
+		next_event_grow_time[i] = plant_type->get_stage_grow_time( stage + 1 );
+	}
+}
+
+void TileGrid::resolve_pending_actions()
+{
+	// actions can wake more tiles, those only join in on the next update
+	size_t count = active_tiles.size();
+	for( size_t i = 0; i < count; ++i )
+	{
+		PendingAction& action = pending_actions[active_tiles[i]];
+		GroundTile& tile = tiles[active_tiles[i]];
+		uint8_t& events = plant_events[active_tiles[i]];
+
+		if( events )
+		{
+			if( ( events & stage_event ) && !tile.is_plant_dead() )
+			{
+				if( tile.plant_type == teleporter_plant )
+				{
+					action.teleport = true;
+				}
+				else if( ( tile.plant_type == spreader_source_plant || tile.plant_type == spreader_child_plant ) && action.spawn_neighbor < 0 )
+				{
+					action.spawn_neighbor = tile.pick_free_neighbor();
+				}
+			}
+			record_change( events == stage_event ? TileChange::stage : TileChange::plant, tile.index );
+			events = 0;
+		}
+
+		if( action.trapped )
+		{
+			for( int n = 0; n < neighbor_count; ++n )
+			{
+				GroundTile& neighbor = get_neighbor( tile.index, n );
+				if( neighbor.is_plant_dead() )
+				{
+					neighbor.try_remove_plant();
+				}
+			}
+		}
+
+		if( action.spawn_neighbor >= 0 )
+		{
+			GroundTile& target = get_neighbor( tile.index, action.spawn_neighbor );
+			// an earlier action may have taken the spot
+			if( target.is_free() )
+			{
+				target.try_add_plant( spreader_child_plant );
+			}
+		}
+
+		if( action.teleport && tile.plant_type == teleporter_plant )
+		{
+			// uniform pick among the other cleared tiles: if the pick lands on the teleporter itself,
+			// take the last entry, which the pick range leaves out
+			if( tile.is_cleared() && cleared_tiles.size() > 1 )
+			{
+				size_t pick = teleport_random.next_below( uint32_t( cleared_tiles.size() - 1 ) );
+				int target = cleared_tiles.indices[pick];
+				if( target == tile.index ) target = cleared_tiles.indices.back();
+				if( GroundTile::try_swap_plants( tile, tiles[target] ) )
+				{
+					record_change( TileChange::teleport, tile.index, target );
+				}
+			}
+		}
+
+		action = PendingAction();
+	}
+}
+
+void TileGrid::put_tiles_to_sleep()
+{
+	// keeps the index order of the tiles left awake
+	size_t kept = 0;
+	for( size_t i = 0; i < active_tiles.size(); ++i )
+	{
+		int index = active_tiles[i];
+		if( can_sleep( index ) )
+		{
+			awake[index] = 0;
+			record_change( TileChange::asleep, index );
+		}
+		else
+		{
+			active_tiles[kept++] = index;
+		}
+	}
+	active_tiles.resize( kept );
+}
+
+void TileGrid::fast_forward( float seconds )
+{
+	if( !( seconds > 0.0f ) ) return;
+	fast_forwarding = true;
+	// one batch for the whole run, handed out while fast_forwarding still tells observers to stay quiet
+	hold_changes++;
+	fast_forward_clock = 0.0f;
+	parked_tiles.clear();
+	settled_tiles.clear();
+
+	// same sized segments of same sized steps, counted so that a clock too coarse to move still gets to the end
+	int64_t segments = int64_t( std::ceil( double( seconds ) / fast_forward_segment ) );
+	float segment = float( double( seconds ) / double( segments ) );
+	int steps = int( std::ceil( segment / fast_forward_step ) );
+	int64_t total_steps = segments * steps;
+	auto clock_at = [&]( int64_t step ) {
+		return float( double( seconds ) * double( step / steps ) / double( segments ) ) + segment * float( step % steps ) / float( steps );
+	};
+	for( int64_t k = 0; k < total_steps; ++k )
+	{
+		int s = int( k % steps );
+		fast_forward_clock = clock_at( k );
+		if( s == 0 )
+		{
+			park_self_contained_tiles();
+			// with every tile parked, settled or asleep nothing interacts anymore: only the closed form is left
+			if( active_tiles.empty() ) break;
+		}
+
+		// changes only matter to the settle check (first step) and to tiles that are settled
+		bool track_changes = s == 0 || settled_count > 0;
+		size_t journal_start = journal.size();
+		if( track_changes ) record_step_start();
+		// parked and settled tiles only wake once the tiles have updated (the step's actions, or the
+		// checks after it), so they catch up to where the step leaves the others
+		fast_forward_clock = clock_at( k + 1 );
+		update( segment / float( steps ) );
+		if( track_changes )
+		{
+			find_changed_tiles( journal_start );
+			if( s == 0 ) settle_quiet_tiles();
+			for( int index : changed_tiles ) step_marks[index] = 0;
+			changed_tiles.clear();
+		}
+
+		if( s == 0 )
+		{
+			record_cycle_start();
+		}
+		else if( int period = find_cycle_period() )
+		{
+			k += ( total_steps - k - 1 ) / period * period;
+		}
+	}
+	fast_forward_clock = seconds;
+
+	// bring the parked tiles up to date and hand them and the settled ones back to the regular update
+	for( int index : parked_tiles )
+	{
+		if( parked_at[index] >= 0.0f ) wake( index );
+	}
+	parked_tiles.clear();
+	for( int index : settled_tiles )
+	{
+		if( settled[index] ) wake( index );
+	}
+	settled_tiles.clear();
+	if( --hold_changes == 0 ) flush_changes();
+	fast_forwarding = false;
+}
+
+bool TileGrid::is_self_contained( int index )
+{
+	// no aura to decay into the moisture, and a plant that neither reads nor writes its neighbors
+	if( fire_aura_effect[index] > 0.0f || aqua_aura_effect[index] > 0.0f ) return false;
+	GroundTile& tile = tiles[index];
+	return !tile.plant_type || tile.is_plant_dead() || tile.plant_type == test_plant || tile.plant_type == cactus_plant;
+}
+
+void TileGrid::park_self_contained_tiles()
+{
+	if( !active_tiles_sorted )
+	{
+		std::sort( active_tiles.begin(), active_tiles.end() );
+		active_tiles_sorted = true;
+	}
+
+	// tiles next to one that interacts stay in the coarse steps, it may write to or read them
+	size_t kept = 0;
+	for( size_t i = 0; i < active_tiles.size(); ++i )
+	{
+		int index = active_tiles[i];
+		bool park = is_self_contained( index );
+		for( int n = 0; n < neighbor_count && park; ++n )
+		{
+			if( !is_self_contained( get_neighbor_index( index, n ) ) ) park = false;
+		}
+		if( park )
+		{
+			awake[index] = 0;
+			parked_at[index] = fast_forward_clock;
+			parked_tiles.emplace_back( index );
+		}
+		else
+		{
+			active_tiles[kept++] = index;
+		}
+	}
+	active_tiles.resize( kept );
+}
+
+bool TileGrid::SettleState::operator==( SettleState const& other ) const
+{
+	// moisture gets compared by is_settle_change
+	return plant_health == other.plant_health && fertilization == other.fertilization
+		&& fire_aura_effect == other.fire_aura_effect && aqua_aura_effect == other.aqua_aura_effect
+		&& current_grow_time == other.current_grow_time && random_state == other.random_state
+		&& plant_type == other.plant_type && tile_type == other.tile_type;
+}
+
+TileGrid::SettleState TileGrid::get_settle_state( int index )
+{
+	return SettleState{ plant_health[index], moisture[index], fertilization[index], fire_aura_effect[index],
+		aqua_aura_effect[index], current_grow_time[index], random_state[index], tiles[index].plant_type, tiles[index].tile_type };
+}
+
+bool TileGrid::is_only_drying( int index )
+{
+	// auras move moisture, and plants read it until they are grown
+	GroundTile& tile = tiles[index];
+	bool unread = !tile.plant_type || tile.is_plant_dead() || tile.is_tile_harvestable();
+	return unread && fire_aura_effect[index] <= 0.0f && aqua_aura_effect[index] <= 0.0f;
+}
+
+bool TileGrid::is_settle_change( int index, SettleState const& before )
+{
+	SettleState after = get_settle_state( index );
+	if( !( after == before ) ) return true;
+	// with the rest unchanged, no aura was on the tile before the step if there's none now
+	return after.moisture != before.moisture && !is_only_drying( index );
+}
+
+void TileGrid::record_step_start()
+{
+	if( !active_tiles_sorted )
+	{
+		std::sort( active_tiles.begin(), active_tiles.end() );
+		active_tiles_sorted = true;
+	}
+	step_start_tiles = active_tiles;
+	step_start_states.resize( step_start_tiles.size() );
+	for( size_t i = 0; i < step_start_tiles.size(); ++i )
+	{
+		step_start_states[i] = get_settle_state( step_start_tiles[i] );
+		step_marks[step_start_tiles[i]] = at_step_start;
+	}
+}
+
+void TileGrid::find_changed_tiles( size_t journal_start )
+{
+	auto mark = [this]( int index ) {
+		if( step_marks[index] & changed_in_step ) return;
+		step_marks[index] |= changed_in_step;
+		changed_tiles.emplace_back( index );
+	};
+	for( size_t i = 0; i < step_start_tiles.size(); ++i )
+	{
+		if( is_settle_change( step_start_tiles[i], step_start_states[i] ) ) mark( step_start_tiles[i] );
+	}
+	// woken during the step, or changed by an action (try_remove_plant doesn't wake the tile)
+	for( int index : active_tiles )
+	{
+		if( !( step_marks[index] & at_step_start ) ) mark( index );
+	}
+	for( size_t i = journal_start; i < journal.size(); ++i )
+	{
+		mark( journal[i].index );
+		if( journal[i].other_index >= 0 ) mark( journal[i].other_index );
+	}
+	for( int index : step_start_tiles ) step_marks[index] &= uint8_t( ~at_step_start );
+
+	// whatever settled in reach of a change has to run again
+	int r = get_settle_radius();
+	for( size_t i = 0; i < changed_tiles.size() && settled_count > 0; ++i )
+	{
+		int index = changed_tiles[i];
+		for( int dx = -r; dx <= r; ++dx )
+		{
+			for( int dy = std::abs( dx ) - r; dy <= r - std::abs( dx ); ++dy )
+			{
+				int x = tiles[index].grid_x + dx;
+				int y = tiles[index].grid_y + dy;
+				if( is_in_grid( x, y ) && settled[get_index( x, y )] ) wake( get_index( x, y ) );
+			}
+		}
+	}
+}
+
+void TileGrid::settle_quiet_tiles()
+{
+	// drop the tiles that woke up since they settled, so nobody is in the list twice
+	if( settled_tiles.size() != size_t( settled_count ) )
+	{
+		settled_tiles.erase( std::remove_if( settled_tiles.begin(), settled_tiles.end(), [this]( int index ) { return !settled[index]; } ), settled_tiles.end() );
+	}
+
+	int r = get_settle_radius();
+	size_t kept = 0;
+	for( size_t i = 0; i < active_tiles.size(); ++i )
+	{
+		int index = active_tiles[i];
+		GroundTile& tile = tiles[index];
+		// beacons with a wider radius spread from their update, they can't keep a mask set
+		bool quiet = !step_marks[index] && !( beacon_aura_radius > 1 && tile.plant_type == beaconflower_plant );
+		for( int dx = -r; dx <= r && quiet; ++dx )
+		{
+			for( int dy = std::abs( dx ) - r; dy <= r - std::abs( dx ) && quiet; ++dy )
+			{
+				int x = tile.grid_x + dx;
+				int y = tile.grid_y + dy;
+				if( is_in_grid( x, y ) && step_marks[get_index( x, y )] ) quiet = false;
+			}
+		}
+		if( !quiet )
+		{
+			active_tiles[kept++] = index;
+			continue;
+		}
+
+		// the aura the tile gave off this step keeps spreading from the mask
+		AuraKind::Type aura_type = tile.get_emitted_aura();
+		if( aura_type != AuraKind::none ) ( aura_type == AuraKind::fire ? fire_emitter : aqua_emitter )[index] = 1.0f;
+		tile.shake = 0.0f;
+		previous_grow_time[index] = current_grow_time[index];
+		if( moisture[index] > 0.0f && is_only_drying( index ) ) drying_since[index] = fast_forward_clock;
+		awake[index] = 0;
+		settled[index] = 1;
+		settled_count++;
+		settled_tiles.emplace_back( index );
+	}
+	active_tiles.resize( kept );
+}
+
+void TileGrid::record_cycle_start()
+{
+	cycle_tiles = active_tiles;
+	cycle_states.resize( cycle_tiles.size() );
+	for( size_t i = 0; i < cycle_tiles.size(); ++i )
+	{
+		cycle_states[i] = get_settle_state( cycle_tiles[i] );
+	}
+	cycle_teleport_random = teleport_random.state;
+	cycle_journal_start = journal.size();
+	cycle_journal_quiet = true;
+	cycle_steps = 0;
+	cycle_power = 1;
+}
+
+int TileGrid::find_cycle_period()
+{
+	cycle_steps++;
+	// auras are part of the compared state, anything else in the journal changed more than that
+	for( ; cycle_journal_start < journal.size(); ++cycle_journal_start )
+	{
+		if( journal[cycle_journal_start].kind != TileChange::aura ) cycle_journal_quiet = false;
+	}
+
+	// settled, parked and sleeping tiles stay as they are while the awake ones don't wake or change them
+	bool same = cycle_journal_quiet && active_tiles == cycle_tiles && teleport_random.state == cycle_teleport_random;
+	for( size_t i = 0; i < cycle_tiles.size() && same; ++i )
+	{
+		int index = cycle_tiles[i];
+		same = get_settle_state( index ) == cycle_states[i] && moisture[index] == cycle_states[i].moisture;
+	}
+	if( same ) return cycle_steps;
+
+	// not back yet: look for the current state instead, after twice as many steps as the last time
+	if( cycle_steps == cycle_power )
+	{
+		int power = cycle_power * 2;
+		record_cycle_start();
+		cycle_power = power;
+	}
+	return 0;
+}
+
+void TileGrid::unsettle( int index )
+{
+	// the writes that piled up while settled didn't change anything (that's why it settled)
+	settled[index] = 0;
+	settled_count--;
+	if( drying_since[index] >= 0.0f )
+	{
+		moisture[index] = std::max( 0.0f, moisture[index] - GroundTile::moisture_dry_rate * ( fast_forward_clock - drying_since[index] ) );
+		drying_since[index] = -1.0f;
+	}
+	fire_emitter[index] = 0.0f;
+	aqua_emitter[index] = 0.0f;
+	for( int slot = 0; slot < neighbor_count; ++slot )
+	{
+		pending_update.current_grow_time[slot][index] = 0.0f;
+	}
+	for( int slot = 0; slot < pending_slot_count; ++slot )
+	{
+		pending_update.plant_health[slot][index] = 0.0f;
+	}
+}
+
+void TileGrid::catch_up( int index )
+{
+	if( parked_at[index] < 0.0f || parked_at[index] == fast_forward_clock ) return;
+	advance_self_contained( index, fast_forward_clock - parked_at[index] );
+	parked_at[index] = fast_forward_clock;
+}
+
+// integral of sqrt( value + rate * t ) over [0, duration], value stays >= 0
+static float integrate_sqrt( float value, float rate, float duration )
+{
+	if( rate == 0.0f ) return std::sqrt( value ) * duration;
+	float end = std::max( 0.0f, value + rate * duration );
+	return 2.0f / ( 3.0f * rate ) * ( end * std::sqrt( end ) - value * std::sqrt( value ) );
+}
+
+void TileGrid::advance_self_contained( int index, float duration )
+{
+	// same rules as GroundTile::update without any neighbor, integrated over the duration:
+	// moisture dries linearly, health changes at one rate while fertilized and another one after
+	GroundTile& tile = tiles[index];
+	tile.shake = 0.0f;
+
+	float dry = GroundTile::moisture_dry_rate;
+	float moisture_start = moisture[index];
+	float dry_time = std::min( duration, moisture_start / dry );
+	moisture[index] = std::max( 0.0f, moisture_start - dry * duration );
+	previous_grow_time[index] = current_grow_time[index];
+
+	if( !tile.plant_type ) return;
+	float fertilized_time = std::min( duration, fertilization[index] );
+	fertilization[index] = std::max( 0.0f, fertilization[index] - duration );
+	if( tile.is_plant_dead() ) return;
+
+	// a cactus without fire aura wilts, the fern always recovers
+	float rate = GroundTile::plant_health_restore_rate;
+	if( tile.plant_type == cactus_plant ) rate -= GroundTile::plant_health_restore_rate + 0.1f;
+	bool grows = tile.plant_type == test_plant;
+
+	float health = plant_health[index];
+	float grow = 0.0f;
+	float pieces[2][2] = {
+		{ fertilized_time, rate + GroundTile::plant_health_fertilization_restore_rate },
+		{ duration - fertilized_time, rate } };
+	for( auto const& piece : pieces )
+	{
+		float time = piece[0];
+		float piece_rate = piece[1];
+		if( time <= 0.0f ) continue;
+		// health stops changing once it hits 0 or 1
+		float change_time = time;
+		if( piece_rate > 0.0f ) change_time = std::min( time, ( 1.0f - health ) / piece_rate );
+		if( piece_rate < 0.0f ) change_time = std::min( time, health / -piece_rate );
+		float end_health = change_time < time ? ( piece_rate > 0.0f ? 1.0f : 0.0f ) : std::min( 1.0f, std::max( 0.0f, health + piece_rate * time ) );
+		if( grows ) grow += integrate_sqrt( health, piece_rate, change_time ) + std::sqrt( end_health ) * ( time - change_time );
+		health = end_health;
+		if( health <= 0.0f ) break;
+	}
+	if( grows ) grow += integrate_sqrt( moisture_start, -dry, dry_time );
+
+	current_grow_time[index] = std::min( tile.plant_type->get_growth_time(), current_grow_time[index] + grow );
+	previous_grow_time[index] = current_grow_time[index];
+	tile.change_health( health - plant_health[index] );
+
+	collect_plant_event( index );
+	if( plant_events[index] )
+	{
+		record_change( plant_events[index] == stage_event ? TileChange::stage : TileChange::plant, index );
+		plant_events[index] = 0;
+	}
+}
@@ -0,0 +1,475 @@
+#pragma once
+
+#include "AuraKind.hpp"
+#include "Random.hpp"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Tile, plant and grid rules of the game. Nothing in here draws or plays sounds, so it also
+// runs headless (see simbench.cpp); the game attaches its presentation as a TileObserver.
+
+struct TileGrid;
+struct WorkerPool;
+
+/* Contains info on how a plant works */
+struct PlantType
+{
+	PlantType( int stage_count_in,
+			   AuraKind::Type aura_type_in,
+			   int cost_in = 5,
+			   int harvest_gain_in = 7,
+			   float growth_time_in = 5.0f,
+			   std::string name_in = "Default Name",
+			   std::string description_in = "Default Description." )
+		:stage_count( stage_count_in ),
+		aura_type( aura_type_in ),
+		growth_time( growth_time_in ),
+		cost( cost_in ),
+		harvest_gain( harvest_gain_in ),
+		name( name_in ),
+		description( description_in ) {
+		assert( stage_count > 0 );
+	};
+
+	float get_stage_percent( float percent_grown ) const {
+		float float_index = ( glm::max( 0.0f, percent_grown ) * ( stage_count - 1 ) );
+		return percent_grown >= 1.0f ? 1.0f : float_index - floor( float_index );
+	};
+	int get_growth_stage( float percent_grown ) const {
+		return percent_grown >= 1.0f ?
+			stage_count - 1 :
+			int( floor( glm::max( 0.0f, percent_grown ) * ( stage_count - 1 ) ) );
+	}
+	// grow time at which a stage starts (the last one starts when the plant is harvestable)
+	float get_stage_grow_time( int stage ) const {
+		return stage_count <= 1 || stage >= stage_count - 1 ?
+			growth_time :
+			growth_time * float( stage ) / float( stage_count - 1 );
+	}
+
+	int get_stage_count() const { return stage_count; };
+	AuraKind::Type get_aura_type() const { return aura_type; };
+	float get_growth_time() const { return growth_time; };
+	int get_cost() const { return cost; };
+	int get_harvest_gain() const { return harvest_gain; };
+	std::string get_name() const { return name; }
+	std::string get_description() const { return description; };
+	// index in all_plants, for the PerPlant arrays
+	int get_id() const { return id; }
+
+private:
+	friend void create_plant_types();
+	friend void tune_plant_type( PlantType const* plant, int cost, float growth_time );
+	int id = -1;
+	int stage_count = 1;
+	AuraKind::Type aura_type = AuraKind::none;
+	float growth_time = 5.0f;
+	int cost = 5;
+	int harvest_gain = 7;
+	std::string name = "Default Name";
+	std::string description = "Default Description.";
+};
+
+/* Contains info on how a tile works */
+struct GroundTileType
+{
+	GroundTileType( bool can_plant_in, int clear_cost_in ) : clear_cost(clear_cost_in), can_plant( can_plant_in ){};
+	int get_clear_cost() const{ return clear_cost; };
+	bool get_can_plant() const { return can_plant; };
+
+private:
+	int clear_cost = 40;
+	bool can_plant = true;
+};
+
+/* Actual instance of a tile with a plant. Only the cold data (types, position in the grid) lives here,
+ * the per-frame values are stored column-wise in the owning TileGrid */
+struct GroundTile
+{
+	void change_tile_type( const GroundTileType* tile_type_in );
+	void update( float elapsed );
+	
+	static bool try_swap_plants(GroundTile& tile_a, GroundTile& tile_b );
+	bool try_add_plant( const PlantType* plant_type_in );
+	bool try_remove_plant();
+	void clear_auras();
+	
+	bool is_tile_harvestable();
+	bool is_plant_dead();
+	bool can_plant();
+	
+	bool can_be_cleared() const;
+	bool try_clear_tile();
+	bool is_cleared() const;
+	bool is_free() const; // cleared and without a plant
+	
+	void change_health( float change );
+
+	// Deferred changes, safe to call while other tiles update in parallel:
+	// every write goes to a slot owned by this tile (see TileGrid::pending_update)
+	void queue_change_health( float change );
+	void queue_neighbor_change_health( int neighbor, float change );
+	void queue_neighbor_grow( int neighbor, float change );
+	void emit_aura( AuraKind::Type aura_type, bool from_beacon );
+	// fire or aqua if the plant gives off that aura this update, none otherwise
+	AuraKind::Type get_emitted_aura();
+	uint32_t next_random();
+	int8_t pick_free_neighbor();
+
+	// put back into the grid's active set after something changed on the tile
+	void wake();
+
+	// Hot tile data (see TileGrid)
+	float& plant_health();
+	float& moisture();
+	float& fertilization();
+	float& fire_aura_effect(); // in range 0 - 1
+	float& aqua_aura_effect();
+	float& current_grow_time();
+
+	// Tile and plant types
+	const GroundTileType* tile_type = nullptr;
+	const PlantType* plant_type = nullptr;
+
+	// Tile data
+	TileGrid* grid = nullptr;
+	int index = 0;
+	int grid_x = 0;
+	int grid_y = 0;
+
+	float shake = 0.0f;
+
+	static constexpr float plant_health_restore_rate = 1.0f / 5.0f;
+	static constexpr float plant_health_fertilization_restore_rate = 1.0f / 3.0f;
+	static constexpr float moisture_dry_rate = 0.01f;
+};
+
+/* One entry of a grid's change journal (see TileGrid::journal) */
+struct TileChange
+{
+	enum Kind : uint8_t { tile_type, plant, stage, died, aura, teleport, asleep };
+	Kind kind;
+	int index;
+	int other_index; // teleport target, -1 otherwise
+	bool skipped; // recorded during fast_forward
+};
+
+/* Gets told about changes to tiles, in batches from the grid's change journal */
+struct TileObserver
+{
+	virtual ~TileObserver() { }
+	virtual void on_tile_type_changed( GroundTile& tile ) { }
+	// plant added, removed, swapped in, became harvestable or died
+	virtual void on_plant_changed( GroundTile& tile ) { }
+	// plant reached a new growth stage
+	virtual void on_plant_stage_changed( GroundTile& tile ) { on_plant_changed( tile ); }
+	virtual void on_plant_died( GroundTile& tile ) { }
+	// fire or aqua aura appeared on the tile or went away
+	virtual void on_aura_changed( GroundTile& tile ) { }
+	virtual void on_teleport( GroundTile& from, GroundTile& to ) { }
+	virtual void on_tile_asleep( GroundTile& tile ) { }
+};
+
+/* Set of tile indices with O(1) insert, erase, membership and random pick.
+ * Erasing moves the last entry into the hole, so the order is arbitrary (but deterministic). */
+struct TileIndexSet
+{
+	std::vector< int > indices;
+	std::vector< int > positions; // per tile, -1 if not in the set
+
+	void resize( size_t tile_count ) { indices.clear(); positions.assign( tile_count, -1 ); }
+	bool contains( int index ) const { return positions[index] >= 0; }
+	size_t size() const { return indices.size(); }
+	void insert( int index );
+	void erase( int index );
+	void set( int index, bool in_set ) { if( in_set ) insert( index ); else erase( index ); }
+};
+
+/* A grid snapshot that has been read and checked but not loaded yet (see TileGrid::read_snapshot).
+ * Types cover the tiles inside the grid (x-major), the columns include the border */
+struct GridSnapshot
+{
+	uint32_t teleport_random = 0;
+	std::vector< GroundTileType const* > tile_types;
+	std::vector< PlantType const* > plant_types;
+	std::vector< float > plant_health;
+	std::vector< float > moisture;
+	std::vector< float > fertilization;
+	std::vector< float > fire_aura_effect;
+	std::vector< float > aqua_aura_effect;
+	std::vector< float > current_grow_time;
+	std::vector< float > next_event_grow_time;
+	std::vector< int8_t > plant_stage;
+	std::vector< uint32_t > random_state;
+	std::vector< uint8_t > awake;
+	std::vector< int > cleared_tiles;
+	std::vector< int > free_tiles;
+};
+
+/* Tile storage. Values touched every frame are kept as contiguous columns (structure of arrays)
+ * indexed by get_index( x, y ), so the decay and clamp passes stream through memory.
+ * Everything else sits in the GroundTile side-table.
+ * The grid is stored with a one tile border of border_tile sentinels around it: they have no plant,
+ * can't be planted or cleared and never wake, so neighbor access needs no bounds checks.
+ * Tiles update in parallel: during GroundTile::update a tile only reads shared state and writes
+ * to its own entries, so the result does not depend on the number of threads. */
+struct TileGrid
+{
+	int size_x = 0;
+	int size_y = 0;
+	int stride = 0; // size_y plus the border on both sides
+
+	// cold side-table
+	std::vector< GroundTile > tiles;
+
+	// hot columns
+	std::vector< float > plant_health;
+	std::vector< float > moisture;
+	std::vector< float > fertilization;
+	std::vector< float > fire_aura_effect;
+	std::vector< float > aqua_aura_effect;
+	std::vector< float > current_grow_time;
+	std::vector< uint32_t > random_state; // per tile stream, see seed_random
+	std::vector< float > previous_grow_time; // before the last update, for render interpolation
+
+	// plant timeline: instead of polling the growth stage every frame, each plant keeps the
+	// grow time of its next event. Crossing it (or dying) raises the events for that update
+	enum PlantEvent : uint8_t { stage_event = 1, harvestable_event = 2, death_event = 4 };
+	std::vector< float > next_event_grow_time;
+	std::vector< int8_t > plant_stage;
+	std::vector< uint8_t > plant_events;
+
+	// neighbors in x-major order, so summing the slots in order matches a serial sweep
+	static constexpr int neighbor_count = 4;
+	static const int neighbor_dx[neighbor_count];
+	static const int neighbor_dy[neighbor_count];
+	static int opposite_neighbor( int neighbor ) { return neighbor_count - 1 - neighbor; }
+	int neighbor_offset[neighbor_count] = { }; // index offsets matching neighbor_dx/dy, set by resize
+	int get_neighbor_index( int index, int neighbor ) const { return index + neighbor_offset[neighbor]; }
+	GroundTile& get_neighbor( int index, int neighbor ) { return tiles[index + neighbor_offset[neighbor]]; }
+
+	// each time a tile updates, it modifies nearby tiles' pending update columns
+	// which get applied at the end of update call. A tile writes into the neighbor's slot
+	// that faces back at it (or into self_slot for its own changes), so no two tiles share a slot
+	enum { self_slot = neighbor_count, pending_slot_count };
+	struct {
+		std::vector< float > current_grow_time[neighbor_count];
+		std::vector< float > plant_health[pending_slot_count];
+	} pending_update;
+
+	// aura spread runs as dense passes over the padded columns (see update_auras): tiles giving off
+	// fire or aqua aura this update set their emitter mask to 1, then every tile that can be planted
+	// takes aura_spread_rate from each marked neighbor. The masks are cleared once they are used
+	std::vector< float > fire_emitter;
+	std::vector< float > aqua_emitter;
+	std::vector< float > aura_receiver; // 1 if the tile type can be planted, 0 otherwise
+	static constexpr float aura_spread_rate = 0.2f;
+	static constexpr float aura_decay_rate = 0.1f;
+	// how far (manhattan distance) beacon flowers pass their aura on. Beyond 1, beacons skip the
+	// masks and spread from PendingAction::wide_aura instead
+	int beacon_aura_radius = 1;
+
+	// changes to plants & tiles that can't be done in parallel, resolved in index order
+	struct PendingAction
+	{
+		bool trapped = false; // spreader digs out dead neighbors
+		int8_t spawn_neighbor = -1; // spreader grows into this neighbor
+		bool teleport = false; // teleporter swaps with a random plant
+		uint8_t wake_neighbors = 0; // bit per neighbor that got written to
+		AuraKind::Type wide_aura = AuraKind::none; // beacon aura spread over beacon_aura_radius
+	};
+	std::vector< PendingAction > pending_actions;
+	RandomStream teleport_random;
+
+	// cleared tiles (teleporter targets) and cleared tiles without a plant (spreader targets),
+	// kept current by update_tile_indices whenever a tile type or plant changes
+	TileIndexSet cleared_tiles;
+	TileIndexSet free_tiles;
+	// per tile, bit n set if neighbor n is in free_tiles (spreaders check this instead of their neighbors)
+	std::vector< uint8_t > free_neighbors;
+	void update_tile_indices( int index );
+	void set_free( int index, bool free );
+
+	// tiles that get simulated, in index order. A tile sleeps once nothing can change on it:
+	// no plant, no aura and moisture that is either dry or unused by the tile type
+	std::vector< int > active_tiles;
+	std::vector< uint8_t > awake;
+	bool active_tiles_sorted = true;
+
+	void wake( int index );
+	void wake_parked_neighbors( int index ); // see fast_forward
+	bool can_sleep( int index );
+
+	// presentation (drawables, sounds, ...) follows the grid through these
+	std::vector< TileObserver* > observers;
+
+	// changes in the order they happened, not handed to the observers yet. Outside of updates every
+	// change goes out right away; while hold_changes is above zero (during update and fast_forward, or
+	// while a worker steps the grid) they pile up and flush_changes hands them over in one batch
+	std::vector< TileChange > journal;
+	int hold_changes = 0;
+	void record_change( TileChange::Kind kind, int index, int other_index = -1 );
+	void flush_changes();
+	// per tile, bit 0 / bit 1 if the fire / aqua aura was above zero when last checked for aura changes
+	std::vector< uint8_t > aura_shown;
+	void check_aura( int index );
+
+	// worker threads to spread tile updates on (serial if null, or with fewer tiles awake than
+	// min_parallel_tiles: waking the workers would take longer than the updates)
+	WorkerPool* workers = nullptr;
+	static constexpr size_t min_parallel_tiles = 256;
+
+	void resize( int size_x_in, int size_y_in );
+	int get_index( int x, int y ) const { return ( x + 1 ) * stride + ( y + 1 ); }
+	GroundTile& get_tile( int x, int y ) { return tiles[get_index( x, y )]; }
+	bool is_in_grid( int x, int y ) const;
+
+	// restart the tile and teleport random streams from a run seed
+	void seed_random( uint32_t seed );
+
+	// binary snapshot of every tile in the read_write_chunk.hpp format. Taken between updates, so there
+	// is nothing pending. Loading goes in two steps: read_snapshot parses the chunks and checks them
+	// against this grid (throws std::runtime_error and leaves the grid alone), then apply_snapshot
+	// moves the columns in. The one argument read_snapshot does both
+	static constexpr uint32_t snapshot_version = 2;
+	void write_snapshot( std::ostream* to );
+	void read_snapshot( std::istream& from, GridSnapshot* snapshot ) const;
+	void apply_snapshot( GridSnapshot& snapshot );
+	void read_snapshot( std::istream& from );
+
+	// updates every tile then applies the pending changes. Called with a fixed step
+	void update( float elapsed );
+
+	// dense passes over the hot columns, run after every tile has updated
+	void update_tile_state( float elapsed );
+	void update_auras( float elapsed );
+	void spread_wide_auras( float elapsed );
+	void apply_pending_update( float elapsed );
+	void collect_plant_events();
+	void collect_plant_event( int index );
+	void resolve_pending_actions();
+	void put_tiles_to_sleep();
+
+	// advances the grid by seconds without stepping every tile every frame (offline and idle progress).
+	// Self-contained tiles, which neither read nor get written to by a neighbor, are parked and
+	// integrated in closed form when they are needed again. Tiles whose surroundings stopped changing
+	// are settled and skipped until something near them changes; the rest runs coarse steps
+	void fast_forward( float seconds );
+	static constexpr float fast_forward_step = 0.25f;
+	static constexpr float fast_forward_segment = 5.0f; // tiles get parked and settled again this often
+
+	bool is_self_contained( int index );
+	void park_self_contained_tiles();
+	void catch_up( int index ); // bring a parked tile to fast_forward_clock
+	void advance_self_contained( int index, float duration );
+
+	// also set while the changes recorded during a fast_forward get handed out, however late that is
+	bool fast_forwarding = false;
+	float fast_forward_clock = 0.0f;
+	std::vector< float > parked_at; // fast_forward_clock when the tile got parked, -1 if it isn't
+	std::vector< int > parked_tiles;
+
+	// A tile's update only depends on the tiles within two steps of it (its neighbors, and what they
+	// read of theirs) and on beacons within beacon_aura_radius. If none of those changed during a step,
+	// the next step leaves the tile as it is too: every rate is clamped at a bound by then. Such a tile
+	// settles: it stops updating, what its neighbors write to it is dropped, and its aura emitter mask
+	// stays set. It wakes up (see wake) as soon as a tile within get_settle_radius changes.
+	// Moisture is the one exception: without aura on the tile it only dries, and once the plant is
+	// grown (or gone) nothing reads it, so it may keep drying and is integrated when the tile wakes.
+	// What is left for the coarse steps is inherently interacting: spreaders filling the free tiles
+	// (a freshly planted field spends its first simulated minute there) and fights between vampires
+	// and regrowing spreaders. Those run at one update per coarse step
+	struct SettleState
+	{
+		float plant_health, moisture, fertilization, fire_aura_effect, aqua_aura_effect, current_grow_time;
+		uint32_t random_state;
+		PlantType const* plant_type;
+		GroundTileType const* tile_type;
+		bool operator==( SettleState const& other ) const;
+	};
+	SettleState get_settle_state( int index );
+	bool is_only_drying( int index ); // moisture changes by the drying alone and nothing reads it
+	bool is_settle_change( int index, SettleState const& before );
+	int get_settle_radius() const { return std::max( 2, beacon_aura_radius ); }
+	void record_step_start();
+	void find_changed_tiles( size_t journal_start );
+	void settle_quiet_tiles();
+	void unsettle( int index );
+
+	std::vector< uint8_t > settled;
+	std::vector< float > drying_since; // fast_forward_clock when a settled tile started drying unstepped, -1 if it isn't
+	int settled_count = 0;
+	std::vector< int > settled_tiles; // may hold tiles that woke up since, see settle_quiet_tiles
+	// per step bookkeeping: the active tiles and their state before the step, and per tile marks
+	enum StepMark : uint8_t { at_step_start = 1, changed_in_step = 2 };
+	std::vector< int > step_start_tiles;
+	std::vector< SettleState > step_start_states;
+	std::vector< uint8_t > step_marks;
+	std::vector< int > changed_tiles;
+
+	// Closed loops that never settle (beacons passing their auras back and forth) come back to the same
+	// state: once every awake tile is where it was some steps ago and nothing but auras changed in
+	// between, the steps repeat exactly and fast_forward skips whole periods of them.
+	// Looked for Brent style, the state to come back to moves ahead at each power of two steps
+	void record_cycle_start();
+	int find_cycle_period();
+	std::vector< int > cycle_tiles;
+	std::vector< SettleState > cycle_states;
+	uint32_t cycle_teleport_random = 0;
+	size_t cycle_journal_start = 0;
+	int cycle_steps = 0; // since the state in cycle_states
+	int cycle_power = 1; // steps until that state moves ahead
+	bool cycle_journal_quiet = true;
+};
+
+inline float& GroundTile::plant_health() { return grid->plant_health[index]; }
+inline float& GroundTile::moisture() { return grid->moisture[index]; }
+inline float& GroundTile::fertilization() { return grid->fertilization[index]; }
+inline float& GroundTile::fire_aura_effect() { return grid->fire_aura_effect[index]; }
+inline float& GroundTile::aqua_aura_effect() { return grid->aqua_aura_effect[index]; }
+inline float& GroundTile::current_grow_time() { return grid->current_grow_time[index]; }
+
+const int fertilization_cost = 10;
+const float fertilization_duration = 5.0f;
+
+// create the plant and tile types below (once)
+void create_plant_types();
+extern PlantType const* test_plant;
+extern PlantType const* friend_plant;
+extern PlantType const* vampire_plant;
+extern PlantType const* cactus_plant;
+extern PlantType const* fireflower_plant;
+extern PlantType const* waterflower_plant;
+extern PlantType const* beaconflower_plant;
+extern PlantType const* corpseeater_plant;
+extern PlantType const* spreader_source_plant;
+extern PlantType const* spreader_child_plant;
+extern PlantType const* teleporter_plant;
+extern std::vector< PlantType const* > all_plants;
+// one value per plant type, indexed by PlantType::get_id()
+constexpr int plant_type_count = 11;
+template< typename T > using PerPlant = std::array< T, plant_type_count >;
+extern std::vector< GroundTileType const* > all_tile_types;
+extern GroundTileType const* sea_tile;
+extern GroundTileType const* ground_tile;
+extern GroundTileType const* grass_short_tile;
+extern GroundTileType const* grass_tall_tile;
+extern GroundTileType const* dirt_tile;
+extern GroundTileType const* empty_tile;
+extern GroundTileType const* border_tile; // sentinels around the grid, not in all_tile_types
+
+// balancing runs (batchsim) change the economy of a plant type before any game starts
+void tune_plant_type( PlantType const* plant, int cost, float growth_time );
+
+// the island a new game starts on, x + y * starting_island_size:
+//  o empty, d dirt, x short grass, X tall grass, C cleared ground
+const int starting_island_size = 10;
+extern char const* const starting_island;
+GroundTileType const* get_island_tile_type( char c );
@@ -0,0 +1,101 @@
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+WorkerPool::WorkerPool( int thread_count ) {
+	if( thread_count <= 0 ) {
+		thread_count = std::max( 1, int( std::thread::hardware_concurrency() ) );
+	}
+	for( int i = 1; i < thread_count; ++i ) {
+		workers.emplace_back( [this](){ work(); } );
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::unique_lock< std::mutex > lock( mutex );
+		quit = true;
+	}
+	wake.notify_all();
+	for( auto &w : workers ) {
+		w.join();
+	}
+}
+
+void WorkerPool::run( int job_count, std::function< void( int ) > const &fn ) {
+	if( job_count <= 0 ) return;
+	//not worth waking anyone up:
+	if( workers.empty() || job_count == 1 ) {
+		for( int job = 0; job < job_count; ++job ) {
+			fn( job );
+		}
+		return;
+	}
+
+	Batch batch;
+	batch.fn = &fn;
+	batch.count = job_count;
+	{
+		std::unique_lock< std::mutex > lock( mutex );
+		batches.emplace_back( &batch );
+	}
+	wake.notify_all();
+
+	//every job this thread doesn't take is already running elsewhere, so waiting below can't deadlock:
+	take_jobs( batch );
+
+	std::unique_lock< std::mutex > lock( mutex );
+	done.wait( lock, [&](){ return batch.finished.load() == batch.count && batch.takers == 0; } );
+	batches.erase( std::find( batches.begin(), batches.end(), &batch ) );
+}
+
+void WorkerPool::run_ranges( size_t count, std::function< void( size_t, size_t ) > const &fn, int ranges_per_thread ) {
+	if( count == 0 ) return;
+	size_t ranges = std::min( count, size_t( get_thread_count() ) * size_t( std::max( 1, ranges_per_thread ) ) );
+	size_t range_size = ( count + ranges - 1 ) / ranges;
+	ranges = ( count + range_size - 1 ) / range_size;
+	run( int( ranges ), [&]( int job ){
+		size_t begin = size_t( job ) * range_size;
+		size_t end = std::min( count, begin + range_size );
+		fn( begin, end );
+	} );
+}
+
+void WorkerPool::take_jobs( Batch &batch ) {
+	while( true ) {
+		int job = batch.next.fetch_add( 1 );
+		if( job >= batch.count ) break;
+		(*batch.fn)( job );
+		if( batch.finished.fetch_add( 1 ) + 1 == batch.count ) {
+			std::unique_lock< std::mutex > lock( mutex );
+			done.notify_all();
+		}
+	}
+}
+
+WorkerPool::Batch *WorkerPool::open_batch() {
+	//nested batches come last, and their callers wait on them:
+	for( auto b = batches.rbegin(); b != batches.rend(); ++b ) {
+		if( (*b)->next.load() < (*b)->count ) return *b;
+	}
+	return nullptr;
+}
+
+void WorkerPool::work() {
+	while( true ) {
+		Batch *batch = nullptr;
+		{
+			std::unique_lock< std::mutex > lock( mutex );
+			wake.wait( lock, [&](){ return quit || ( batch = open_batch() ) != nullptr; } );
+			if( quit ) return;
+			batch->takers += 1;
+		}
+		take_jobs( *batch );
+		{
+			std::unique_lock< std::mutex > lock( mutex );
+			batch->takers -= 1;
+			if( batch->takers == 0 ) done.notify_all();
+		}
+	}
+}
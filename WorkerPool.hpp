@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//A WorkerPool keeps a few threads around to split per-frame work across cores.
+//
+// WorkerPool pool;
+// pool.run( job_count, [&]( int job ){ ... } );
+//
+//run() blocks until every job is done; the calling thread also takes jobs.
+//Jobs must not depend on the order they run in.
+//Jobs may call run() themselves: the nested batch gets queued next to the ones already running, and
+//idle threads take from the newest batch first, so the pool stays busy with no job waiting on another.
+
+struct WorkerPool {
+	//thread_count includes the calling thread; 0 picks one per hardware thread:
+	WorkerPool( int thread_count = 0 );
+	~WorkerPool();
+
+	WorkerPool( WorkerPool const & ) = delete;
+	WorkerPool &operator=( WorkerPool const & ) = delete;
+
+	void run( int job_count, std::function< void( int ) > const &fn );
+
+	//split [0, count) into contiguous ranges, roughly 'ranges_per_thread' per thread:
+	void run_ranges( size_t count, std::function< void( size_t, size_t ) > const &fn, int ranges_per_thread = 4 );
+
+	int get_thread_count() const { return int( workers.size() ) + 1; }
+
+	//-- internals ---
+	//one run() call's jobs, on its caller's stack:
+	struct Batch {
+		std::function< void( int ) > const *fn = nullptr;
+		int count = 0;
+		std::atomic< int > next{ 0 };
+		std::atomic< int > finished{ 0 };
+		int takers = 0; //workers taking jobs from it (guarded by mutex)
+	};
+
+	void work();
+	void take_jobs( Batch &batch );
+	//newest batch with jobs left to take, if any (call with mutex held):
+	Batch *open_batch();
+
+	std::vector< std::thread > workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+
+	std::vector< Batch * > batches;
+	bool quit = false;
+};
@@ -0,0 +1,371 @@
+#include "TileGrid.hpp"
+#include "Order.hpp"
+#include "GameState.hpp"
+#include "WorkerPool.hpp"
+#include "Random.hpp"
+#include "Load.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * batchsim: plays many seeded games headless and at once, for balancing the economy.
+ *
+ * Usage:
+ *   ./batchsim [--games N] [--seed N] [--threads N] [--minutes M] [--step SECONDS] [--random-daily 0|1]
+ *              [--plant NAME:cost=N,growth=SECONDS]... [--beacon-radius N] [--csv games.csv] [--summary summary.csv]
+ *
+ * Game i is seeded with mix_seed(seed, i) and owns its grid, GameState and random streams,
+ * so games run on any thread in any order and still come out the same. Each one is played by a
+ * simple greedy player (see BatchGame::think) under the rules of GameState, like PlantMode, until the last main
+ * order is done, the player can't afford the orders anymore, or M simulated minutes passed.
+ * --plant changes a plant's cost and growth time (the NAME used in the order files) before any game runs.
+ * --beacon-radius sets how far beacon flowers pass their aura on (PlantMode::beacon_aura_radius in the game).
+ * --csv writes a row per game, --summary a row with the totals; the totals are also printed.
+ */
+
+struct GameResult {
+	uint32_t seed = 0;
+	std::string outcome = "timeout"; //won, lost or timeout
+	float minutes = 0.0f;
+	int main_orders = 0;
+	int daily_orders = 0;
+	int coins = 0;
+	int seeds_bought = 0;
+	int harvested = 0;
+	int died = 0;
+	int tiles_cleared = 0;
+};
+
+//a game under the rules of GameState, the same ones PlantMode plays by; counts what happens for the result:
+struct BatchGame : TileObserver, GameObserver {
+	BatchGame(uint32_t seed_, bool random_daily, int beacon_radius) : seed(seed_),
+		player_random(mix_seed(seed_, autoplay_stream)), order_random(mix_seed(seed_, order_stream)) {
+		grid.resize(starting_island_size, starting_island_size);
+		grid.beacon_aura_radius = beacon_radius;
+		grid.seed_random(seed);
+		grid.observers.push_back(this);
+		for (int x = 0; x < starting_island_size; ++x) {
+			for (int y = 0; y < starting_island_size; ++y) {
+				grid.get_tile(x, y).change_tile_type(get_island_tile_type(starting_island[x + y * starting_island_size]));
+			}
+		}
+		if (random_daily) state.daily_random = &order_random;
+		state.order_tracker.track(grid);
+		state.observer = this;
+		state.reset();
+		result.seed = seed;
+	}
+
+	uint32_t seed;
+	RandomStream player_random;
+	RandomStream order_random;
+
+	TileGrid grid;
+	GameState state;
+	GameResult result;
+
+	virtual void on_plant_died(GroundTile &tile) override { result.died += 1; }
+	virtual void on_order_completed(int slot) override {
+		if (slot == GameState::main_order_slot) result.main_orders += 1;
+		else result.daily_orders += 1;
+	}
+
+	bool buy_seed(PlantType const *plant) {
+		if (!state.buy_seed(plant)) return false;
+		result.seeds_bought += 1;
+		return true;
+	}
+
+	//uniform pick among the tiles with the highest score (nullptr if every score is negative):
+	template< typename Score >
+	GroundTile *pick_tile(Score const &score) {
+		GroundTile *picked = nullptr;
+		int best = 0;
+		uint32_t seen = 0;
+		for (int x = 0; x < grid.size_x; ++x) {
+			for (int y = 0; y < grid.size_y; ++y) {
+				GroundTile &tile = grid.get_tile(x, y);
+				int tile_score = int(score(tile));
+				if (tile_score < 0 || (picked && tile_score < best)) continue;
+				if (!picked || tile_score > best) {
+					best = tile_score;
+					seen = 0;
+				}
+				seen += 1;
+				if (player_random.next_below(seen) == 0) picked = &tile;
+			}
+		}
+		return picked;
+	}
+	//a lambda returning bool scores the tiles it wants 0, the rest -1:
+	template< typename Want >
+	GroundTile *pick_wanted_tile(Want const &want) {
+		return pick_tile([&want](GroundTile &tile){ return want(tile) ? 0 : -1; });
+	}
+
+	//coins kept back when clearing ground:
+	static constexpr int clear_reserve = 10;
+
+	int living_neighbors(GroundTile &tile) {
+		int neighbors = 0;
+		for (int n = 0; n < TileGrid::neighbor_count; ++n) {
+			GroundTile &neighbor = grid.get_neighbor(tile.index, n);
+			if (neighbor.plant_type && !neighbor.is_plant_dead()) neighbors += 1;
+		}
+		return neighbors;
+	}
+	//a growing plant would lose one of the neighbors or the fire aura it needs if this plant went away:
+	bool props_up_neighbor(GroundTile &tile) {
+		if (tile.plant_type == fireflower_plant) {
+			for (GroundTile &other : grid.tiles) {
+				if (other.plant_type == cactus_plant && !other.is_plant_dead() && !other.is_tile_harvestable()) return true;
+			}
+		}
+		for (int n = 0; n < TileGrid::neighbor_count; ++n) {
+			GroundTile &neighbor = grid.get_neighbor(tile.index, n);
+			if (!neighbor.plant_type || neighbor.is_plant_dead() || neighbor.is_tile_harvestable()) continue;
+			if (living_neighbors(neighbor) <= neighbors_needed(neighbor.plant_type)) return true;
+		}
+		return false;
+	}
+	static int neighbors_needed(PlantType const *plant) {
+		if (plant == friend_plant) return 2;
+		if (plant == vampire_plant) return 3;
+		return 0;
+	}
+	//free tile next to the most living plants, for the plants that feed on neighbors, and in fire for cacti:
+	GroundTile *best_tile_for(PlantType const *plant) {
+		return pick_tile([this, plant](GroundTile &tile){
+			if (!tile.can_plant()) return -1;
+			int score = living_neighbors(tile);
+			if (plant == cactus_plant && tile.fire_aura_effect() > 0.1f) score += TileGrid::neighbor_count + 1;
+			return score;
+		});
+	}
+	//the plant that has to go in first for 'plant' to grow on this tile (nullptr if it grows as is):
+	PlantType const *support_for(PlantType const *plant, GroundTile &tile) {
+		if (living_neighbors(tile) < neighbors_needed(plant)) return test_plant;
+		if (plant == cactus_plant && tile.fire_aura_effect() <= 0.1f) return fireflower_plant;
+		return nullptr;
+	}
+
+	//one decision of the player, takes the first thing on this list that can be done:
+	// complete an order, harvest or clean up a plant, water a dry plant, plant what the orders
+	// are missing next to other plants (buying the seed, or planting the ferns or fire flowers it
+	// needs first), clear more ground when out of room
+	void think() {
+		if (state.complete_order(GameState::main_order_slot) || state.complete_order(GameState::daily_order_slot)) return;
+
+		if (GroundTile *tile = pick_wanted_tile([this](GroundTile &tile){
+			if (!tile.plant_type) return false;
+			if (tile.is_plant_dead()) return true;
+			return tile.is_tile_harvestable() && !props_up_neighbor(tile);
+		})) {
+			if (state.remove_plant(*tile)) result.harvested += 1;
+			return;
+		}
+
+		if (GroundTile *tile = pick_wanted_tile([](GroundTile &tile){ return tile.plant_type && !tile.is_plant_dead() && tile.moisture() < 0.3f; })) {
+			tile->moisture() = 1.0f;
+			tile->wake();
+			return;
+		}
+
+		if (pick_wanted_tile([](GroundTile &tile){ return tile.can_plant(); })) {
+			for (int slot = 0; slot < 2; ++slot) {
+				OrderType const *order = state.order_tracker.get_order(slot);
+				for (int id : order->get_required_ids()) {
+					PlantType const *plant = all_plants[id];
+					if (state.order_tracker.get_missing_num(slot, plant) == 0 && state.get_seeds_num(plant) == 0) continue;
+					if (!state.is_unlocked(plant)) continue;
+					GroundTile *free_tile = best_tile_for(plant);
+					//plant what it needs to grow there first:
+					if (PlantType const *support = support_for(plant, *free_tile)) {
+						if (!state.is_unlocked(support)) continue;
+						plant = support;
+						if (state.get_seeds_num(plant) == 0 && state.num_coins - plant->get_cost() < state.get_debt()) return;
+					}
+					if (state.get_seeds_num(plant) == 0 && !buy_seed(plant)) continue;
+					state.plant_seed(*free_tile, plant);
+					return;
+				}
+			}
+			return;
+		}
+
+		//only what's left over after buying both orders, with a seed or two to spare:
+		int budget = state.num_coins - state.order_tracker.get_missing_cost(GameState::main_order_slot)
+			- state.order_tracker.get_missing_cost(GameState::daily_order_slot) - clear_reserve;
+		if (GroundTile *tile = pick_wanted_tile([budget](GroundTile &tile){ return tile.can_be_cleared() && tile.tile_type->get_clear_cost() <= budget; })) {
+			if (state.clear_tile(*tile)) result.tiles_cleared += 1;
+		}
+	}
+
+	void play(float minutes, float step, float think_interval) {
+		float time = 0.0f;
+		float think_timer = 0.0f;
+		float end = minutes * 60.0f;
+		while (state.outcome == GameState::playing && time < end) {
+			think_timer -= step;
+			while (state.outcome == GameState::playing && think_timer <= 0.0f) {
+				think();
+				think_timer += think_interval;
+			}
+			grid.update(step);
+			time += step;
+		}
+		result.minutes = time / 60.0f;
+		result.coins = state.num_coins;
+		if (state.outcome == GameState::won) result.outcome = "won";
+		if (state.outcome == GameState::lost) result.outcome = "lost";
+	}
+};
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+	try { //windows doesn't print nice errors for unhandled exceptions, so we need to.
+#endif
+	int games = 1000;
+	uint32_t seed = 1;
+	int threads = 0;
+	float minutes = 30.0f;
+	float step = 1.0f / 60.0f; //same step as PlantMode
+	const float think_interval = 0.5f; //a click every half second
+	bool random_daily = false;
+	int beacon_radius = 1;
+	std::vector< std::string > plant_tunings;
+	std::string csv_path;
+	std::string summary_path;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			std::cerr << "Missing value for '" << arg << "'." << std::endl;
+			return 1;
+		}
+		std::string value = argv[++i];
+		if (arg == "--games") {
+			games = std::stoi(value);
+		} else if (arg == "--seed") {
+			seed = uint32_t(std::stoul(value));
+		} else if (arg == "--threads") {
+			threads = std::stoi(value);
+		} else if (arg == "--minutes") {
+			minutes = std::stof(value);
+		} else if (arg == "--step") {
+			step = std::stof(value);
+		} else if (arg == "--random-daily") {
+			random_daily = (value != "0");
+		} else if (arg == "--plant") {
+			plant_tunings.emplace_back(value);
+		} else if (arg == "--beacon-radius") {
+			beacon_radius = std::max(1, std::stoi(value));
+		} else if (arg == "--csv") {
+			csv_path = value;
+		} else if (arg == "--summary") {
+			summary_path = value;
+		} else {
+			std::cerr << "Usage:\n\t./batchsim [--games N] [--seed N] [--threads N] [--minutes M] [--step SECONDS] [--random-daily 0|1] [--plant NAME:cost=N,growth=SECONDS]... [--beacon-radius N] [--csv games.csv] [--summary summary.csv]" << std::endl;
+			return 1;
+		}
+	}
+
+	create_plant_types();
+	//the order files:
+	call_load_functions();
+	if (main_orders.empty() || daily_orders.empty()) {
+		std::cerr << "No orders loaded (are 'main_order' and 'daily_order' next to the executable?)." << std::endl;
+		return 1;
+	}
+
+	for (std::string const &tuning : plant_tunings) {
+		size_t colon = tuning.find(':');
+		PlantType const *plant = get_plant_type_by_name(tuning.substr(0, colon));
+		if (!plant || colon == std::string::npos) {
+			std::cerr << "Bad --plant '" << tuning << "'." << std::endl;
+			return 1;
+		}
+		int cost = plant->get_cost();
+		float growth_time = plant->get_growth_time();
+		std::istringstream str(tuning.substr(colon + 1));
+		std::string entry;
+		while (std::getline(str, entry, ',')) {
+			if (entry.substr(0, 5) == "cost=") cost = std::stoi(entry.substr(5));
+			else if (entry.substr(0, 7) == "growth=") growth_time = std::stof(entry.substr(7));
+			else {
+				std::cerr << "Bad --plant entry '" << entry << "'." << std::endl;
+				return 1;
+			}
+		}
+		tune_plant_type(plant, cost, growth_time);
+	}
+
+	WorkerPool workers(threads);
+	std::cout << games << " games, " << minutes << " minutes each, " << workers.get_thread_count() << " threads, seed " << seed << std::endl;
+
+	std::vector< GameResult > results(games);
+	auto before = std::chrono::high_resolution_clock::now();
+	workers.run(games, [&](int i) {
+		BatchGame game(mix_seed(seed, uint32_t(i)), random_daily, beacon_radius);
+		game.play(minutes, step, think_interval);
+		results[i] = game.result;
+	});
+	double seconds = std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count();
+
+	if (!csv_path.empty()) {
+		std::ofstream csv(csv_path);
+		csv << "seed,outcome,minutes,main_orders,daily_orders,coins,seeds_bought,harvested,died,tiles_cleared\n";
+		for (GameResult const &r : results) {
+			csv << r.seed << ',' << r.outcome << ',' << r.minutes << ',' << r.main_orders << ',' << r.daily_orders << ','
+				<< r.coins << ',' << r.seeds_bought << ',' << r.harvested << ',' << r.died << ',' << r.tiles_cleared << '\n';
+		}
+		if (!csv) std::cerr << "Failed to write '" << csv_path << "'." << std::endl;
+	}
+
+	int won = 0, lost = 0;
+	double win_minutes = 0.0, main_total = 0.0, daily_total = 0.0, coins_total = 0.0, died_total = 0.0;
+	for (GameResult const &r : results) {
+		if (r.outcome == "won") {
+			won += 1;
+			win_minutes += r.minutes;
+		}
+		if (r.outcome == "lost") lost += 1;
+		main_total += r.main_orders;
+		daily_total += r.daily_orders;
+		coins_total += r.coins;
+		died_total += r.died;
+	}
+	double n = std::max(1, games);
+	std::cout << "won " << won << ", lost " << lost << ", timed out " << (games - won - lost)
+		<< "; mean minutes to win " << (won ? win_minutes / won : 0.0)
+		<< ", main orders " << main_total / n << ", daily orders " << daily_total / n
+		<< ", coins " << coins_total / n << ", plants died " << died_total / n << std::endl;
+	std::cout << "simulated " << (games * double(minutes)) << " game minutes in " << seconds << " s ("
+		<< (games / seconds) << " games/s)" << std::endl;
+
+	if (!summary_path.empty()) {
+		std::ofstream summary(summary_path);
+		summary << "games,minutes,seed,won,lost,timeout,mean_minutes_to_win,mean_main_orders,mean_daily_orders,mean_coins,mean_died\n";
+		summary << games << ',' << minutes << ',' << seed << ',' << won << ',' << lost << ',' << (games - won - lost) << ','
+			<< (won ? win_minutes / won : 0.0) << ',' << main_total / n << ',' << daily_total / n << ','
+			<< coins_total / n << ',' << died_total / n << '\n';
+		if (!summary) std::cerr << "Failed to write '" << summary_path << "'." << std::endl;
+	}
+
+	return 0;
+#ifdef _WIN32
+	} catch (std::exception const &e) {
+		std::cerr << "Unhandled exception:\n" << e.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "Unhandled exception (unknown type)." << std::endl;
+		throw;
+	}
+#endif
+}
@@ -0,0 +1,76 @@
+#version 330
+
+// firstpass.vert for Scene's instanced drawing: the object transform and PROPERTIES come per instance
+uniform mat4 WORLD_TO_CLIP;
+uniform mat4x3 WORLD_TO_LIGHT;
+in vec4 Position;
+in vec3 Normal;
+in vec4 Color;
+in vec2 TexCoord;
+in vec3 ObjectToWorld0;
+in vec3 ObjectToWorld1;
+in vec3 ObjectToWorld2;
+in vec3 ObjectToWorld3;
+in vec3 Properties;
+out vec3 position;
+out vec3 normal;
+out vec4 color;
+out vec2 texCoord;
+
+float luminance(vec4 col) {
+	return col.a * ( col.r*0.299 + col.g*0.587 + col.b*0.114 );
+}
+
+vec4 over(vec4 elem, vec4 canvas) {
+  vec4 elem_ = vec4(elem.rgb * elem.a, elem.a);
+  float ca = 1 - (1-elem_.a) * (1-canvas.a);
+  float cr = (1-elem_.a) * canvas.r + elem_.r;
+  float cg = (1-elem_.a) * canvas.g + elem_.g;
+  float cb = (1-elem_.a) * canvas.b + elem_.b;
+  return vec4(cr, cg, cb, ca);
+}
+
+vec4 color_from_health(vec4 col, float health) {
+	if (health == 1.0f) return col;
+
+	// overlay with tint color
+	vec4 overlay = over(vec4(0.6078, 0.3255, 0, 0.75), col);
+	// preserve luminance
+	vec4 l = overlay * ( luminance(col) / luminance(overlay) );
+	vec4 l_clamped = vec4( min(1, l.r), min(1, l.g), min(1, l.b), min(1, l.a) );// TODO
+	// multiply to make darker
+	vec4 multiply = l_clamped * 0.3;
+	// full unhealthy color
+	vec4 unhealthy = multiply;
+
+	// lerp to get result
+	return mix(unhealthy, col, health);
+}
+
+vec4 soil_color(vec4 dry_col, float moisture) {
+	vec4 wet_col = vec4(51.0f/255.0f, 39.0f/255.0f, 28.0f/255.0f, 1.0f);
+	return mix(dry_col, wet_col, moisture);
+}
+
+void main() {
+	float health = Properties.x;
+	float moisture = Properties.y;
+
+	mat4 object_to_world = mat4(
+		vec4(ObjectToWorld0, 0.0), vec4(ObjectToWorld1, 0.0), vec4(ObjectToWorld2, 0.0), vec4(ObjectToWorld3, 1.0)
+	);
+	mat4x3 object_to_light = WORLD_TO_LIGHT * object_to_world;
+	// the tile transforms are rotation and scale only (no parent, no shear) and WORLD_TO_LIGHT is rigid,
+	// so the inverse transpose is the matrix with each column divided by its squared length
+	mat3 normal_to_light = mat3(object_to_light);
+	normal_to_light[0] /= max(dot(normal_to_light[0], normal_to_light[0]), 1e-20);
+	normal_to_light[1] /= max(dot(normal_to_light[1], normal_to_light[1]), 1e-20);
+	normal_to_light[2] /= max(dot(normal_to_light[2], normal_to_light[2]), 1e-20);
+
+	gl_Position = WORLD_TO_CLIP * object_to_world * Position;
+	position = object_to_light * Position;
+	normal = normal_to_light * Normal;
+	color = color_from_health(Color, health);
+	color = soil_color(color, moisture);
+	texCoord = TexCoord;
+}
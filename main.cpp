@@ -4,6 +4,7 @@
 //Starting mode:
 //#include "demo_menu.hpp"
 #include "PlantMode.hpp"
+#include "AutoplayMode.hpp"
 
 //Deal with calling resource loading functions:
 #include "Load.hpp"
@@ -14,6 +15,9 @@
 //Sound subsystem:
 #include "Sound.hpp"
 
+//Simulation random streams:
+#include "Random.hpp"
+
 //for screenshots:
 #include "load_save_png.hpp"
 
@@ -26,6 +30,7 @@
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include <string>
 
 int main(int argc, char **argv) {
 #ifdef _WIN32
@@ -93,8 +98,27 @@ int main(int argc, char **argv) {
 	//set up sound output:
 	Sound::init();
 
-	//random seed
-	srand((unsigned int)(time(0)));
+	//random seed (pass '--seed N' for a reproducible run):
+	uint32_t seed = uint32_t(time(0));
+	//'--autoplay [policy]' lets AutoplayMode play (see AutoplayMode.hpp):
+	bool autoplay = false;
+	std::string autoplay_policy;
+	//'--islands N' plays on an archipelago of N islands (switch the visible one with 'i'):
+	int islands = 1;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--seed" && i + 1 < argc) seed = uint32_t(std::stoul(argv[i+1]));
+		if (arg == "--islands" && i + 1 < argc) islands = std::stoi(argv[i+1]);
+		if (arg == "--autoplay") {
+			autoplay = true;
+			if (i + 1 < argc && std::string(argv[i+1]).substr(0, 2) != "--") autoplay_policy = argv[i+1];
+		}
+	}
+	srand(seed);
+	seed_random_streams(seed);
+
+	//autoplay runs uncapped:
+	if (autoplay) SDL_GL_SetSwapInterval(0);
 
 	//Hide mouse cursor (note: showing can be useful for debugging):
 	SDL_ShowCursor(SDL_DISABLE);
@@ -104,7 +128,11 @@ int main(int argc, char **argv) {
 
 	//------------ create game mode + make current --------------
 	//Mode::set_current(demo_menu);
-	Mode::set_current(std::make_shared< PlantMode >());
+	if (autoplay) {
+		Mode::set_current(std::make_shared< AutoplayMode >(std::make_shared< PlantMode >(islands), AutoplayMode::Policy::parse(autoplay_policy), seed));
+	} else {
+		Mode::set_current(std::make_shared< PlantMode >(islands));
+	}
 
 	//------------ main loop ------------
 
@@ -54,6 +54,7 @@ GLuint make_vao_for_program(std::map< std::string, Attrib const * > const &attri
 		//call glVertexAttribPointer (or integer variant):
 		attrib.VertexAttribPointer(location);
 		glEnableVertexAttribArray(location);
+		if (attrib.divisor != 0) glVertexAttribDivisor(location, attrib.divisor);
 
 		//remember that it was bound:
 		bound.insert(location);
@@ -24,6 +24,8 @@ struct Attrib {
 	} interpretation = AsFloat;
 	GLsizei stride = 0;
 	GLsizei offset = 0;
+	//advance once per this many instances instead of once per vertex (0 == per vertex); passed to glVertexAttribDivisor
+	GLuint divisor = 0;
 
 	//constructors:
 	Attrib() = default;
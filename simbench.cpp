@@ -0,0 +1,262 @@
+#include "TileGrid.hpp"
+#include "Archipelago.hpp"
+#include "WorkerPool.hpp"
+#include "Random.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * simbench: runs the tile simulation headless (no window, GL or sound) and reports how fast it goes.
+ *
+ * Usage:
+ *   ./simbench [--sizes 10,32,64,128] [--mix fern|aura|mixed|spreader] [--ticks N] [--threads N] [--seed N]
+ *              [--fast-forward SECONDS] [--check 0|1] [--snapshot ROUNDS] [--islands N] [--beacon-radius N]
+ *
+ * Every size runs the same number of fixed steps on a fully cleared, square grid planted with the given mix.
+ * With --islands, that many such grids run side by side as an Archipelago (one job per island).
+ * With --fast-forward, each grid instead skips ahead by that many seconds with TileGrid::fast_forward.
+ *  Unless --check is 0, the result is then checked against the same world updated in every one of the coarse
+ *  steps fast_forward takes. A tile is off if it holds another plant (or the same one, dead in just one of
+ *  them), or if moisture, auras, health or grow time (as a fraction of the growth time) differ by more than
+ *  ff_tolerance: parked tiles get integrated exactly, where the steps sum up their growth at the start of
+ *  each step. The rounding can also move a death that falls right on a step by one step, and the tiles
+ *  around it follow until the field settles, so up to ff_tiles_off of the tiles may be off (seeds 1-10
+ *  with the mixed, aura and spreader mixes came out at 0.55% at most). A failed check exits with 1.
+ * With --snapshot, the final grid is also written to and read back from memory that many times.
+ * --beacon-radius sets TileGrid::beacon_aura_radius; beyond 1 beacons take the wide spread path, which
+ *  the --fast-forward check then covers too (e.g. --mix aura --beacon-radius 3 --fast-forward 600).
+ */
+
+//what fast_forward must come out as: every tile updated in the coarse steps it takes
+static void step_through(TileGrid &grid, float seconds) {
+	int64_t segments = int64_t(std::ceil(double(seconds) / TileGrid::fast_forward_segment));
+	float segment = float(double(seconds) / double(segments));
+	int steps = int(std::ceil(segment / TileGrid::fast_forward_step));
+	for (int64_t k = 0; k < segments * steps; ++k) {
+		grid.update(segment / float(steps));
+	}
+}
+
+static const float ff_tolerance = 0.01f;
+static const double ff_tiles_off = 0.01;
+
+//counts the tiles that are off, and how far the values of the others are apart at most:
+struct FastForwardCheck {
+	size_t failed_tiles = 0;
+	float max_difference = 0.0f;
+
+	void compare(TileGrid &skipped, TileGrid &stepped) {
+		for (int x = 0; x < skipped.size_x; ++x) {
+			for (int y = 0; y < skipped.size_y; ++y) {
+				GroundTile &a = skipped.get_tile(x, y);
+				GroundTile &b = stepped.get_tile(x, y);
+				int i = a.index;
+				if (a.plant_type != b.plant_type || a.is_plant_dead() != b.is_plant_dead()) {
+					++failed_tiles;
+					continue;
+				}
+				float difference = std::max({
+					std::abs(skipped.moisture[i] - stepped.moisture[i]),
+					std::abs(skipped.fire_aura_effect[i] - stepped.fire_aura_effect[i]),
+					std::abs(skipped.aqua_aura_effect[i] - stepped.aqua_aura_effect[i]) });
+				//health and grow time are left over from the last plant on tiles without one:
+				if (a.plant_type) {
+					difference = std::max({ difference,
+						std::abs(skipped.plant_health[i] - stepped.plant_health[i]),
+						std::abs(skipped.current_grow_time[i] - stepped.current_grow_time[i]) / a.plant_type->get_growth_time() });
+				}
+				if (difference > ff_tolerance) ++failed_tiles;
+				else max_difference = std::max(max_difference, difference);
+			}
+		}
+	}
+};
+
+//plants to fill the grid with, cycled in a deterministic shuffle:
+static std::vector< PlantType const * > plants_for_mix(std::string const &mix) {
+	if (mix == "fern") return { test_plant };
+	if (mix == "aura") return { fireflower_plant, waterflower_plant, beaconflower_plant, cactus_plant };
+	if (mix == "spreader") return { spreader_source_plant };
+	if (mix == "mixed") return all_plants;
+	return {};
+}
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+	try { //windows doesn't print nice errors for unhandled exceptions, so we need to.
+#endif
+	std::vector< int > sizes = { 10, 32, 64, 128 };
+	std::string mix = "mixed";
+	int ticks = 600;
+	int threads = 0;
+	uint32_t seed = 1;
+	float fast_forward = 0.0f;
+	int snapshot_rounds = 0;
+	bool check = true;
+	int islands = 1;
+	int beacon_radius = 1;
+	float planted_fraction = 0.5f;
+	const float step = 1.0f / 60.0f; //same step as PlantMode
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			std::cerr << "Missing value for '" << arg << "'." << std::endl;
+			return 1;
+		}
+		std::string value = argv[++i];
+		if (arg == "--sizes") {
+			sizes.clear();
+			std::istringstream str(value);
+			std::string size;
+			while (std::getline(str, size, ',')) sizes.emplace_back(std::stoi(size));
+		} else if (arg == "--mix") {
+			mix = value;
+		} else if (arg == "--ticks") {
+			ticks = std::stoi(value);
+		} else if (arg == "--threads") {
+			threads = std::stoi(value);
+		} else if (arg == "--seed") {
+			seed = uint32_t(std::stoul(value));
+		} else if (arg == "--fast-forward") {
+			fast_forward = std::stof(value);
+		} else if (arg == "--check") {
+			check = (std::stoi(value) != 0);
+		} else if (arg == "--snapshot") {
+			snapshot_rounds = std::stoi(value);
+		} else if (arg == "--islands") {
+			islands = std::max(1, std::stoi(value));
+		} else if (arg == "--beacon-radius") {
+			beacon_radius = std::max(1, std::stoi(value));
+		} else {
+			std::cerr << "Usage:\n\t./simbench [--sizes 10,32,64,128] [--mix fern|aura|mixed|spreader] [--ticks N] [--threads N] [--seed N] [--fast-forward SECONDS] [--check 0|1] [--snapshot ROUNDS] [--islands N] [--beacon-radius N]" << std::endl;
+			return 1;
+		}
+	}
+
+	create_plant_types();
+	std::vector< PlantType const * > plants = plants_for_mix(mix);
+	if (plants.empty()) {
+		std::cerr << "Unknown plant mix '" << mix << "'." << std::endl;
+		return 1;
+	}
+
+	WorkerPool workers(threads);
+	std::cout << "mix " << mix << ", " << ticks << " ticks, " << workers.get_thread_count() << " threads, seed " << seed;
+	if (islands > 1) std::cout << ", " << islands << " islands";
+	if (beacon_radius > 1) std::cout << ", beacon radius " << beacon_radius;
+	std::cout << std::endl;
+
+	bool check_failed = false;
+	for (int size : sizes) {
+		//clear every tile and plant some of them:
+		auto build_world = [&](Archipelago &world) {
+			seed_random_streams(seed);
+			world.step = step;
+			world.workers = &workers;
+			world.beacon_aura_radius = beacon_radius;
+			RandomStream layout(mix_seed(seed, 0));
+			for (int i = 0; i < islands; ++i) {
+				TileGrid &island = world.add_island(size, size).grid;
+				for (int x = 0; x < size; ++x) {
+					for (int y = 0; y < size; ++y) {
+						GroundTile &tile = island.get_tile(x, y);
+						tile.change_tile_type(ground_tile);
+						if (layout.next_float() < planted_fraction) {
+							tile.try_add_plant(plants[layout.next_below(uint32_t(plants.size()))]);
+						}
+					}
+				}
+			}
+		};
+		Archipelago world;
+		build_world(world);
+		TileGrid &grid = world.get_visible().grid;
+
+		auto before = std::chrono::high_resolution_clock::now();
+		if (fast_forward > 0.0f) {
+			world.fast_forward(fast_forward);
+		} else {
+			for (int t = 0; t < ticks; ++t) {
+				world.update(step);
+			}
+		}
+		double seconds = std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count();
+
+		size_t awake = 0;
+		size_t living = 0;
+		for (auto &island : world.islands) {
+			awake += island->grid.active_tiles.size();
+			for (GroundTile &tile : island->grid.tiles) {
+				if (tile.plant_type && !tile.is_plant_dead()) ++living;
+			}
+		}
+
+		if (snapshot_rounds > 0) {
+			double save_seconds = 0.0;
+			double load_seconds = 0.0;
+			size_t bytes = 0;
+			for (int r = 0; r < snapshot_rounds; ++r) {
+				auto start = std::chrono::high_resolution_clock::now();
+				std::ostringstream out;
+				grid.write_snapshot(&out);
+				std::string data = out.str();
+				auto saved = std::chrono::high_resolution_clock::now();
+				std::istringstream in(data);
+				grid.read_snapshot(in);
+				auto loaded = std::chrono::high_resolution_clock::now();
+				save_seconds += std::chrono::duration< double >(saved - start).count();
+				load_seconds += std::chrono::duration< double >(loaded - saved).count();
+				bytes = data.size();
+			}
+			std::cout << size << "x" << size
+				<< ": snapshot " << bytes << " bytes, save " << (save_seconds * 1e3 / snapshot_rounds) << " ms"
+				<< ", load " << (load_seconds * 1e3 / snapshot_rounds) << " ms" << std::endl;
+		}
+
+		if (fast_forward > 0.0f) {
+			std::cout << size << "x" << size
+				<< ": " << fast_forward << "s skipped in " << (seconds * 1e3) << " ms"
+				<< " (" << awake << " awake, " << living << " living plants at the end)" << std::endl;
+			if (check) {
+				Archipelago stepped;
+				build_world(stepped);
+				FastForwardCheck result;
+				for (size_t i = 0; i < world.islands.size(); ++i) {
+					stepped.islands[i]->grid.workers = &workers;
+					step_through(stepped.islands[i]->grid, fast_forward);
+					result.compare(world.islands[i]->grid, stepped.islands[i]->grid);
+				}
+				bool ok = (double(result.failed_tiles) <= ff_tiles_off * double(size) * double(size) * double(islands));
+				std::cout << "  check against every coarse step: " << result.failed_tiles << " tiles off"
+					<< ", largest difference " << result.max_difference
+					<< (ok ? " ok" : " FAILED") << std::endl;
+				if (!ok) check_failed = true;
+			}
+			continue;
+		}
+
+		double tile_ticks = double(ticks) * double(size) * double(size) * double(islands);
+		std::cout << size << "x" << size
+			<< ": " << (ticks / seconds) << " ticks/s"
+			<< ", " << (seconds * 1e9 / tile_ticks) << " ns/tile"
+			<< " (" << awake << " awake, " << living << " living plants at the end)" << std::endl;
+	}
+
+	return check_failed ? 1 : 0;
+#ifdef _WIN32
+	} catch (std::exception const &e) {
+		std::cerr << "Unhandled exception:\n" << e.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "Unhandled exception (unknown type)." << std::endl;
+		throw;
+	}
+#endif
+}